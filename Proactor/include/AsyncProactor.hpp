@@ -0,0 +1,99 @@
+/**
+ * @file AsyncProactor.hpp
+ * @brief Completion-based proactor: accept/recv/send are submitted and their results delivered to handlers
+ *
+ * The io_uring backend queues submissions and hands them to the kernel in one
+ * io_uring_enter() per loop iteration. On kernels without io_uring (or without
+ * the needed opcodes) the epoll backend emulates completions: it waits for
+ * readiness, performs the non-blocking syscall itself and reports the result.
+ * A proactor is single-threaded: submit and run it from the same thread.
+ */
+
+#ifndef ASYNCPROACTOR_HPP
+#define ASYNCPROACTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+typedef enum {
+    ASYNC_BACKEND_URING = 0,
+    ASYNC_BACKEND_EPOLL = 1
+} async_backend_t;
+
+typedef enum {
+    ASYNC_OP_ACCEPT = 0,
+    ASYNC_OP_RECV = 1,
+    ASYNC_OP_SEND = 2
+} async_op_t;
+
+/**
+ * @brief Completion handler
+ *
+ * @param proactor proactor the operation was submitted to
+ * @param op completed operation
+ * @param fd fd the operation was submitted on (the listener for accept)
+ * @param result syscall-style result: new fd for accept, bytes for recv/send, -errno on failure.
+ *               A send completes only once all bytes are sent or it failed.
+ * @param arg user argument given at submission
+ */
+typedef void (*asyncHandler)(void* proactor, async_op_t op, int fd, int result, void* arg);
+
+/**
+ * @brief Creates a proactor, using io_uring when the kernel supports it and epoll otherwise
+ *
+ * @param entries submission queue size (io_uring) / ready list size (epoll)
+ * @return pointer to the proactor or nullptr on failure
+ */
+void* startAsyncProactor(unsigned int entries);
+
+/**
+ * @brief Creates a proactor on the given backend, without fallback
+ */
+void* startAsyncProactorWithBackend(async_backend_t backend, unsigned int entries);
+
+/**
+ * @brief Returns the backend a proactor runs on
+ */
+async_backend_t asyncProactorBackend(void* proactor);
+
+/**
+ * @brief Submits an accept on a listening socket. Accepted sockets are non-blocking with the epoll backend.
+ * @return 0 on success, -1 on failure
+ */
+int asyncAccept(void* proactor, int listenfd, asyncHandler handler, void* arg);
+
+/**
+ * @brief Submits a recv of up to len bytes into buf. buf must stay valid until the completion.
+ * @return 0 on success, -1 on failure
+ */
+int asyncRecv(void* proactor, int fd, void* buf, size_t len, asyncHandler handler, void* arg);
+
+/**
+ * @brief Submits a send of len bytes from buf. buf must stay valid until the completion.
+ * @return 0 on success, -1 on failure
+ */
+int asyncSend(void* proactor, int fd, const void* buf, size_t len, asyncHandler handler, void* arg);
+
+/**
+ * @brief Runs the completion loop until stopAsyncProactor is called
+ *
+ * Each iteration submits every queued operation in one syscall, then delivers
+ * all available completions to their handlers.
+ *
+ * @return 0 on success, -1 on failure
+ */
+int runAsyncProactor(void* proactor);
+
+/**
+ * @brief Asks the loop to return. Safe to call from another thread or a signal handler.
+ * @return 0 on success, -1 on failure
+ */
+int stopAsyncProactor(void* proactor);
+
+/**
+ * @brief Frees a proactor whose loop is not running. Pending operations are dropped.
+ * @return 0 on success, -1 on failure
+ */
+int freeAsyncProactor(void* proactor);
+
+#endif //ASYNCPROACTOR_HPP
@@ -1,10 +1,94 @@
+#ifndef PROACTOR_HPP
+#define PROACTOR_HPP
 #include <pthread.h>
 #include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 
 typedef void* (*proactorFunc) (void* sockfd);
-// starts new proactor and returns proactor thread id. 
+// starts new proactor and returns proactor thread id.
+// Compatibility shim: runs threadFunc on a thread of its own. Use the pool below for client sockets.
 pthread_t startProactor (int* sockfd, proactorFunc threadFunc);
-// stops proactor by threadid 
-int stopProactor(pthread_t tid);
\ No newline at end of file
+// stops proactor by threadid
+int stopProactor(pthread_t tid);
+
+/*
+ * Pool-backed proactor: a fixed number of worker threads and a bounded task queue.
+ * Watched fds are armed one-shot in an epoll dispatcher; when an fd becomes readable
+ * a task is queued and a worker runs its handler, then its completion callback.
+ * A fd is never handled by two workers at once.
+ */
+#define PROACTOR_REARM 0  /* handler result: keep watching the fd */
+#define PROACTOR_CLOSE 1  /* handler result: stop watching the fd */
+
+// Handler run on a worker. Returns PROACTOR_REARM or PROACTOR_CLOSE.
+typedef int (*proactorHandler) (int fd, void* arg);
+// Completion callback run on the same worker with the handler's result.
+typedef void (*proactorCompletion) (int fd, int result, void* arg);
+
+struct proactor_task {
+    int fd;
+    struct proactor_task* registration; /* watched fd's registration, nullptr for one-off tasks */
+    proactorHandler handler;
+    proactorCompletion done;
+    void* arg;
+    struct timespec enqueued_at; /* for queue wait time */
+};
+
+struct proactor_metrics {
+    uint64_t tasks_completed;    /* tasks run to completion */
+    uint64_t queue_full_waits;   /* submissions that had to wait for a free slot */
+    double avg_queue_wait_us;    /* mean time from enqueue to a worker picking the task up */
+    double max_queue_wait_us;
+    double utilization;          /* busy time / (workers * uptime), 0..1 */
+    int queued;                  /* tasks waiting right now */
+    int workers;
+    int queue_depth;
+};
+
+typedef struct proactor_metrics proactor_metrics_t;
+
+struct proactor_pool {
+    pthread_t* workers;
+    int nworkers;
+    pthread_t dispatcher;        /* epoll loop for watched fds */
+    int epfd;
+    int wakefd;                  /* eventfd that wakes the dispatcher on stop */
+    int running;
+
+    struct proactor_task* queue; /* circular buffer of queue_depth tasks */
+    int queue_depth;
+    int head;
+    int count;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+
+    struct timespec started_at;
+    uint64_t tasks_completed;    /* metrics, guarded by lock */
+    uint64_t tasks_dequeued;     /* taken off the queue, running ones included */
+    uint64_t queue_full_waits;
+    uint64_t wait_ns_total;
+    uint64_t wait_ns_max;
+    uint64_t busy_ns_total;
+};
+
+typedef struct proactor_pool proactor_pool_t;
+
+// starts a pool with nworkers threads and room for queue_depth pending tasks. returns nullptr on failure.
+void* startProactorPool(int nworkers, int queue_depth);
+// watches fd: handler runs on a worker each time fd becomes readable. returns 0 on success, -1 on failure.
+int addFdToProactor(void* proactor, int fd, proactorHandler handler, proactorCompletion done, void* arg);
+// queues a one-off task for fd (no readiness wait). blocks while the queue is full. returns 0 on success.
+int submitToProactor(void* proactor, int fd, proactorHandler handler, proactorCompletion done, void* arg);
+// fills metrics with a snapshot of the pool counters. returns 0 on success, -1 on failure.
+int getProactorMetrics(void* proactor, proactor_metrics_t* metrics);
+// stops the dispatcher and workers, drops pending tasks and frees the pool
+int stopProactorPool(void* proactor);
+#endif //PROACTOR_HPP
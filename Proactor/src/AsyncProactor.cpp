@@ -0,0 +1,603 @@
+#include "../include/AsyncProactor.hpp"
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define WAKE_USER_DATA 0 /* user_data of the eventfd read that wakes the io_uring loop */
+
+struct async_op {
+    async_op_t op;
+    int fd;
+    char* buf;
+    size_t len;
+    size_t done;          /* bytes already sent, sends complete only when done == len */
+    asyncHandler handler;
+    void* arg;
+};
+
+struct fd_ops {           /* epoll backend: pending operations per fd */
+    struct async_op* reader; /* accept or recv */
+    struct async_op* writer; /* send */
+    uint32_t registered;  /* events currently registered with epoll */
+    int dirty;            /* on the dirty list, interest must be synced before waiting */
+};
+
+struct async_proactor {
+    async_backend_t backend;
+    int running;
+    int wakefd;           /* eventfd written by stopAsyncProactor */
+    uint64_t wakebuf;
+
+    /* io_uring backend */
+    int ring_fd;
+    unsigned int *sq_head, *sq_tail, *sq_mask, *sq_entries, *sq_array;
+    unsigned int *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ptr;
+    size_t sq_len;
+    void* cq_ptr;
+    size_t cq_len;
+    size_t sqes_len;
+    unsigned int to_submit; /* SQEs queued since the last io_uring_enter */
+
+    /* epoll backend */
+    int epfd;
+    struct fd_ops* table; /* indexed by fd, grown on demand */
+    int capacity;
+    int* dirty;           /* fds whose pending operations changed */
+    int ndirty;
+    int dirty_capacity;
+    struct epoll_event* events;
+    int max_events;
+};
+
+typedef struct async_proactor async_proactor_t;
+
+static int sys_io_uring_setup(unsigned int entries, struct io_uring_params* p) {
+    return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+    return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned int opcode, void* arg, unsigned int nr_args) {
+    return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static struct async_op* newOp(async_op_t op, int fd, void* buf, size_t len, asyncHandler handler, void* arg) {
+    struct async_op* o = (struct async_op*) malloc(sizeof(struct async_op));
+    if (o == nullptr) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    o->op = op;
+    o->fd = fd;
+    o->buf = (char*) buf;
+    o->len = len;
+    o->done = 0;
+    o->handler = handler;
+    o->arg = arg;
+    return o;
+}
+
+// hands the operation's result to its handler and frees it
+static void completeOp(async_proactor_t* p, struct async_op* o, int result) {
+    async_op_t op = o->op;
+    int fd = o->fd;
+    asyncHandler handler = o->handler;
+    void* arg = o->arg;
+    if (op == ASYNC_OP_SEND && result >= 0) {
+        result = (int) o->done;
+    }
+    free(o);
+    handler(p, op, fd, result, arg);
+}
+
+/* ---------------------------------------------------------------- io_uring */
+
+// kernel needs accept, recv, send and read (for the wake eventfd)
+static int probeUring(int ring_fd) {
+    size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = (struct io_uring_probe*) calloc(1, len);
+    if (probe == nullptr) {
+        return -1;
+    }
+    int ok = sys_io_uring_register(ring_fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    const int needed[] = {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_READ};
+    for (int i = 0; ok && i < 4; i++) {
+        ok = needed[i] <= probe->last_op && (probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+    return ok ? 0 : -1;
+}
+
+static int setupUring(async_proactor_t* p, unsigned int entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    p->ring_fd = sys_io_uring_setup(entries, &params);
+    if (p->ring_fd < 0) {
+        return -1;
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || probeUring(p->ring_fd) == -1) {
+        close(p->ring_fd);
+        p->ring_fd = -1;
+        errno = ENOSYS;
+        return -1;
+    }
+    p->sqes = (struct io_uring_sqe*) MAP_FAILED;
+
+    // SQ and CQ rings share one mapping (IORING_FEAT_SINGLE_MMAP)
+    p->sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    p->cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (p->cq_len > p->sq_len) {
+        p->sq_len = p->cq_len;
+    }
+    p->sq_ptr = mmap(nullptr, p->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     p->ring_fd, IORING_OFF_SQ_RING);
+    if (p->sq_ptr == MAP_FAILED) {
+        close(p->ring_fd);
+        p->ring_fd = -1;
+        return -1;
+    }
+    p->cq_ptr = p->sq_ptr;
+    p->cq_len = 0; // not mapped separately
+
+    p->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    p->sqes = (struct io_uring_sqe*) mmap(nullptr, p->sqes_len, PROT_READ | PROT_WRITE,
+                                          MAP_SHARED | MAP_POPULATE, p->ring_fd, IORING_OFF_SQES);
+    if (p->sqes == MAP_FAILED) {
+        munmap(p->sq_ptr, p->sq_len);
+        close(p->ring_fd);
+        p->ring_fd = -1;
+        return -1;
+    }
+
+    char* sq = (char*) p->sq_ptr;
+    p->sq_head = (unsigned int*) (sq + params.sq_off.head);
+    p->sq_tail = (unsigned int*) (sq + params.sq_off.tail);
+    p->sq_mask = (unsigned int*) (sq + params.sq_off.ring_mask);
+    p->sq_entries = (unsigned int*) (sq + params.sq_off.ring_entries);
+    p->sq_array = (unsigned int*) (sq + params.sq_off.array);
+    char* cq = (char*) p->cq_ptr;
+    p->cq_head = (unsigned int*) (cq + params.cq_off.head);
+    p->cq_tail = (unsigned int*) (cq + params.cq_off.tail);
+    p->cq_mask = (unsigned int*) (cq + params.cq_off.ring_mask);
+    p->cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+    p->to_submit = 0;
+    return 0;
+}
+
+// returns a zeroed SQE, flushing the queue to the kernel first if it is full
+static struct io_uring_sqe* getSqe(async_proactor_t* p) {
+    unsigned int tail = *p->sq_tail;
+    if (tail - __atomic_load_n(p->sq_head, __ATOMIC_ACQUIRE) == *p->sq_entries) {
+        int ret = sys_io_uring_enter(p->ring_fd, p->to_submit, 0, 0);
+        if (ret < 0) {
+            return nullptr;
+        }
+        p->to_submit -= (unsigned int) ret;
+        if (tail - __atomic_load_n(p->sq_head, __ATOMIC_ACQUIRE) == *p->sq_entries) {
+            errno = EBUSY;
+            return nullptr;
+        }
+    }
+    unsigned int index = tail & *p->sq_mask;
+    struct io_uring_sqe* sqe = &p->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    p->sq_array[index] = index;
+    __atomic_store_n(p->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    p->to_submit++;
+    return sqe;
+}
+
+static int queueUringOp(async_proactor_t* p, struct async_op* o) {
+    struct io_uring_sqe* sqe = getSqe(p);
+    if (sqe == nullptr) {
+        return -1;
+    }
+    sqe->fd = o->fd;
+    sqe->user_data = (uint64_t) (uintptr_t) o;
+    switch (o->op) {
+        case ASYNC_OP_ACCEPT:
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->accept_flags = SOCK_CLOEXEC;
+            break;
+        case ASYNC_OP_RECV:
+            sqe->opcode = IORING_OP_RECV;
+            sqe->addr = (uint64_t) (uintptr_t) o->buf;
+            sqe->len = (unsigned int) o->len;
+            break;
+        case ASYNC_OP_SEND:
+            sqe->opcode = IORING_OP_SEND;
+            sqe->addr = (uint64_t) (uintptr_t) (o->buf + o->done);
+            sqe->len = (unsigned int) (o->len - o->done);
+            sqe->msg_flags = MSG_NOSIGNAL;
+            break;
+    }
+    return 0;
+}
+
+static int queueUringWake(async_proactor_t* p) {
+    struct io_uring_sqe* sqe = getSqe(p);
+    if (sqe == nullptr) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = p->wakefd;
+    sqe->addr = (uint64_t) (uintptr_t) &p->wakebuf;
+    sqe->len = sizeof(p->wakebuf);
+    sqe->user_data = WAKE_USER_DATA;
+    return 0;
+}
+
+static int runUringLoop(async_proactor_t* p) {
+    while (__atomic_load_n(&p->running, __ATOMIC_ACQUIRE)) {
+        // one syscall submits everything queued by the previous batch of handlers and waits
+        int ret = sys_io_uring_enter(p->ring_fd, p->to_submit, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("runAsyncProactor: io_uring_enter");
+            return -1;
+        }
+        p->to_submit -= (unsigned int) ret;
+
+        unsigned int head = *p->cq_head;
+        unsigned int tail = __atomic_load_n(p->cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            struct io_uring_cqe cqe = p->cqes[head & *p->cq_mask];
+            head++;
+            __atomic_store_n(p->cq_head, head, __ATOMIC_RELEASE);
+            if (cqe.user_data == WAKE_USER_DATA) {
+                continue;
+            }
+            struct async_op* o = (struct async_op*) (uintptr_t) cqe.user_data;
+            if (o->op == ASYNC_OP_SEND && cqe.res > 0) {
+                o->done += (size_t) cqe.res;
+                if (o->done < o->len && queueUringOp(p, o) == 0) {
+                    continue; // short send: resubmit the rest
+                }
+            }
+            completeOp(p, o, cqe.res);
+        }
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------- epoll */
+
+static int growTable(async_proactor_t* p, int fd) {
+    if (fd < p->capacity) {
+        return 0;
+    }
+    int new_capacity = p->capacity;
+    while (fd >= new_capacity) {
+        new_capacity *= 2;
+    }
+    struct fd_ops* table = (struct fd_ops*) realloc(p->table, new_capacity * sizeof(struct fd_ops));
+    if (table == nullptr) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memset(table + p->capacity, 0, (new_capacity - p->capacity) * sizeof(struct fd_ops));
+    p->table = table;
+    p->capacity = new_capacity;
+    return 0;
+}
+
+static int markDirty(async_proactor_t* p, int fd) {
+    if (p->table[fd].dirty) {
+        return 0;
+    }
+    if (p->ndirty == p->dirty_capacity) {
+        int new_capacity = p->dirty_capacity * 2;
+        int* dirty = (int*) realloc(p->dirty, new_capacity * sizeof(int));
+        if (dirty == nullptr) {
+            errno = ENOMEM;
+            return -1;
+        }
+        p->dirty = dirty;
+        p->dirty_capacity = new_capacity;
+    }
+    p->dirty[p->ndirty++] = fd;
+    p->table[fd].dirty = 1;
+    return 0;
+}
+
+static int queueEpollOp(async_proactor_t* p, struct async_op* o) {
+    if (growTable(p, o->fd) == -1) {
+        return -1;
+    }
+    struct fd_ops* ops = &p->table[o->fd];
+    struct async_op** slot = o->op == ASYNC_OP_SEND ? &ops->writer : &ops->reader;
+    if (*slot != nullptr) {
+        errno = EBUSY; // one pending operation per direction
+        return -1;
+    }
+    if (markDirty(p, o->fd) == -1) {
+        return -1;
+    }
+    *slot = o;
+    return 0;
+}
+
+// performs the non-blocking syscall for o. returns 1 if it completed (result set), 0 if it would block
+static int tryOp(struct async_op* o, int* result) {
+    ssize_t n = 0;
+    switch (o->op) {
+        case ASYNC_OP_ACCEPT:
+            n = accept4(o->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            break;
+        case ASYNC_OP_RECV:
+            n = recv(o->fd, o->buf, o->len, MSG_DONTWAIT);
+            break;
+        case ASYNC_OP_SEND:
+            n = send(o->fd, o->buf + o->done, o->len - o->done, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n > 0) {
+                o->done += (size_t) n;
+                if (o->done < o->len) {
+                    return 0;
+                }
+            }
+            break;
+    }
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        *result = -errno;
+        return 1;
+    }
+    *result = (int) n;
+    return 1;
+}
+
+// runs the pending operation of one direction if the fd is ready for it
+static void dispatchEpollOp(async_proactor_t* p, int fd, int writer) {
+    struct async_op** slot = writer ? &p->table[fd].writer : &p->table[fd].reader;
+    struct async_op* o = *slot;
+    int result;
+    if (o == nullptr || !tryOp(o, &result)) {
+        return;
+    }
+    *slot = nullptr;
+    markDirty(p, fd);
+    if (o->op == ASYNC_OP_ACCEPT && result >= 0 && growTable(p, result) == 0) {
+        // a new fd number: whatever was registered under it belonged to a closed socket
+        p->table[result].registered = 0;
+    }
+    completeOp(p, o, result);
+}
+
+// applies interest changes for dirty fds, trying new sends right away since sockets are usually writable
+static int syncInterest(async_proactor_t* p) {
+    for (int i = 0; i < p->ndirty; i++) {
+        int fd = p->dirty[i];
+        if (p->table[fd].writer != nullptr && p->table[fd].writer->done == 0) {
+            dispatchEpollOp(p, fd, 1); // may complete and append more dirty fds
+        }
+    }
+    for (int i = 0; i < p->ndirty; i++) {
+        int fd = p->dirty[i];
+        struct fd_ops* ops = &p->table[fd];
+        ops->dirty = 0;
+        uint32_t wanted = (ops->reader ? (uint32_t) EPOLLIN : 0u) | (ops->writer ? (uint32_t) EPOLLOUT : 0u);
+        if (wanted == ops->registered) {
+            continue;
+        }
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = wanted;
+        ev.data.fd = fd;
+        int op = ops->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        if (epoll_ctl(p->epfd, op, fd, &ev) == -1) {
+            // the fd was closed (and maybe reused) since we last registered it
+            if (errno == ENOENT) {
+                epoll_ctl(p->epfd, EPOLL_CTL_ADD, fd, &ev);
+            } else if (errno == EEXIST) {
+                epoll_ctl(p->epfd, EPOLL_CTL_MOD, fd, &ev);
+            }
+        }
+        ops->registered = wanted;
+    }
+    p->ndirty = 0;
+    return 0;
+}
+
+static int runEpollLoop(async_proactor_t* p) {
+    while (__atomic_load_n(&p->running, __ATOMIC_ACQUIRE)) {
+        syncInterest(p);
+        int nready = epoll_wait(p->epfd, p->events, p->max_events, -1);
+        if (nready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("runAsyncProactor: epoll_wait");
+            return -1;
+        }
+        for (int i = 0; i < nready; i++) {
+            int fd = p->events[i].data.fd;
+            uint32_t ev = p->events[i].events;
+            if (fd == p->wakefd) {
+                continue;
+            }
+            if (ev & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                dispatchEpollOp(p, fd, 0);
+            }
+            if (ev & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                dispatchEpollOp(p, fd, 1);
+            }
+        }
+    }
+    return 0;
+}
+
+static int setupEpoll(async_proactor_t* p, unsigned int entries) {
+    p->epfd = epoll_create1(EPOLL_CLOEXEC);
+    p->capacity = 64;
+    p->table = (struct fd_ops*) calloc(p->capacity, sizeof(struct fd_ops));
+    p->dirty_capacity = 64;
+    p->dirty = (int*) malloc(p->dirty_capacity * sizeof(int));
+    p->max_events = (int) entries;
+    p->events = (struct epoll_event*) malloc(p->max_events * sizeof(struct epoll_event));
+    if (p->epfd == -1 || p->table == nullptr || p->dirty == nullptr || p->events == nullptr) {
+        return -1;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = p->wakefd;
+    return epoll_ctl(p->epfd, EPOLL_CTL_ADD, p->wakefd, &ev);
+}
+
+/* -------------------------------------------------------------------- API */
+
+void* startAsyncProactorWithBackend(async_backend_t backend, unsigned int entries) {
+    if (entries == 0) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    async_proactor_t* p = (async_proactor_t*) calloc(1, sizeof(async_proactor_t));
+    if (p == nullptr) {
+        perror("Failed to allocate memory for proactor");
+        return nullptr;
+    }
+    p->backend = backend;
+    p->ring_fd = -1;
+    p->epfd = -1;
+    p->running = 1;
+    // io_uring waits on the eventfd with a read, which must not fail with EAGAIN
+    p->wakefd = eventfd(0, EFD_CLOEXEC | (backend == ASYNC_BACKEND_EPOLL ? EFD_NONBLOCK : 0));
+    int ok = p->wakefd != -1;
+    if (ok && backend == ASYNC_BACKEND_URING) {
+        ok = setupUring(p, entries) == 0 && queueUringWake(p) == 0;
+    } else if (ok) {
+        ok = setupEpoll(p, entries) == 0;
+    }
+    if (!ok) {
+        int saved = errno;
+        freeAsyncProactor(p);
+        errno = saved;
+        return nullptr;
+    }
+    return p;
+}
+
+void* startAsyncProactor(unsigned int entries) {
+    void* p = startAsyncProactorWithBackend(ASYNC_BACKEND_URING, entries);
+    if (p == nullptr) {
+        // no io_uring (old kernel, seccomp, missing opcodes): emulate completions
+        p = startAsyncProactorWithBackend(ASYNC_BACKEND_EPOLL, entries);
+    }
+    return p;
+}
+
+async_backend_t asyncProactorBackend(void* proactor) {
+    return ((async_proactor_t*) proactor)->backend;
+}
+
+static int submitOp(void* proactor, async_op_t op, int fd, void* buf, size_t len, asyncHandler handler, void* arg) {
+    async_proactor_t* p = (async_proactor_t*) proactor;
+    if (p == nullptr || fd < 0 || handler == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct async_op* o = newOp(op, fd, buf, len, handler, arg);
+    if (o == nullptr) {
+        return -1;
+    }
+    int ret = p->backend == ASYNC_BACKEND_URING ? queueUringOp(p, o) : queueEpollOp(p, o);
+    if (ret == -1) {
+        free(o);
+    }
+    return ret;
+}
+
+int asyncAccept(void* proactor, int listenfd, asyncHandler handler, void* arg) {
+    async_proactor_t* p = (async_proactor_t*) proactor;
+    if (p != nullptr && p->backend == ASYNC_BACKEND_EPOLL) {
+        // several proactors may wait on one listener: losing the race must not block
+        int flags = fcntl(listenfd, F_GETFL, 0);
+        if (flags != -1 && !(flags & O_NONBLOCK)) {
+            fcntl(listenfd, F_SETFL, flags | O_NONBLOCK);
+        }
+    }
+    return submitOp(proactor, ASYNC_OP_ACCEPT, listenfd, nullptr, 0, handler, arg);
+}
+
+int asyncRecv(void* proactor, int fd, void* buf, size_t len, asyncHandler handler, void* arg) {
+    return submitOp(proactor, ASYNC_OP_RECV, fd, buf, len, handler, arg);
+}
+
+int asyncSend(void* proactor, int fd, const void* buf, size_t len, asyncHandler handler, void* arg) {
+    return submitOp(proactor, ASYNC_OP_SEND, fd, const_cast<void*>(buf), len, handler, arg);
+}
+
+int runAsyncProactor(void* proactor) {
+    async_proactor_t* p = (async_proactor_t*) proactor;
+    if (p == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (p->backend == ASYNC_BACKEND_URING) {
+        return runUringLoop(p);
+    }
+    return runEpollLoop(p);
+}
+
+int stopAsyncProactor(void* proactor) {
+    async_proactor_t* p = (async_proactor_t*) proactor;
+    if (p == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    __atomic_store_n(&p->running, 0, __ATOMIC_RELEASE);
+    uint64_t one = 1;
+    if (write(p->wakefd, &one, sizeof(one)) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+int freeAsyncProactor(void* proactor) {
+    async_proactor_t* p = (async_proactor_t*) proactor;
+    if (p == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (p->ring_fd != -1) {
+        // in-flight operations are cancelled by closing the ring; their async_op records are leaked on purpose
+        munmap(p->sqes, p->sqes_len);
+        munmap(p->sq_ptr, p->sq_len);
+        close(p->ring_fd);
+    }
+    if (p->table != nullptr) {
+        for (int fd = 0; fd < p->capacity; fd++) {
+            free(p->table[fd].reader);
+            free(p->table[fd].writer);
+        }
+    }
+    if (p->epfd != -1) {
+        close(p->epfd);
+    }
+    if (p->wakefd != -1) {
+        close(p->wakefd);
+    }
+    free(p->table);
+    free(p->dirty);
+    free(p->events);
+    free(p);
+    return 0;
+}
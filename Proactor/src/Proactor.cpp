@@ -1,4 +1,5 @@
 #include "../include/Proactor.hpp"
+#include <sys/eventfd.h>
 pthread_t startProactor(int* sockfd, proactorFunc threadFunc)
 {
     pthread_t tid;
@@ -13,3 +14,276 @@ int stopProactor(pthread_t tid)
 {
     return pthread_cancel(tid);
 }
+
+static uint64_t elapsedNs(const struct timespec* from, const struct timespec* to)
+{
+    return (uint64_t)(to->tv_sec - from->tv_sec) * 1000000000ull + (to->tv_nsec - from->tv_nsec);
+}
+
+// pushes a task, waiting for a free slot when the queue is full
+static int enqueueTask(proactor_pool_t* pool, const struct proactor_task* task)
+{
+    pthread_mutex_lock(&pool->lock);
+    if (pool->running && pool->count == pool->queue_depth) {
+        pool->queue_full_waits++;
+        while (pool->running && pool->count == pool->queue_depth) {
+            pthread_cond_wait(&pool->not_full, &pool->lock);
+        }
+    }
+    if (!pool->running) {
+        pthread_mutex_unlock(&pool->lock);
+        errno = ECANCELED;
+        return -1;
+    }
+    struct proactor_task* slot = &pool->queue[(pool->head + pool->count) % pool->queue_depth];
+    *slot = *task;
+    clock_gettime(CLOCK_MONOTONIC, &slot->enqueued_at);
+    pool->count++;
+    pthread_cond_signal(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+static void* workerLoop(void* arg)
+{
+    proactor_pool_t* pool = (proactor_pool_t*)arg;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->running && pool->count == 0) {
+            pthread_cond_wait(&pool->not_empty, &pool->lock);
+        }
+        if (!pool->running) {
+            pthread_mutex_unlock(&pool->lock);
+            return nullptr;
+        }
+        struct proactor_task task = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->queue_depth;
+        pool->count--;
+        struct timespec picked_at;
+        clock_gettime(CLOCK_MONOTONIC, &picked_at);
+        uint64_t wait_ns = elapsedNs(&task.enqueued_at, &picked_at);
+        pool->wait_ns_total += wait_ns;
+        pool->tasks_dequeued++;
+        if (wait_ns > pool->wait_ns_max) {
+            pool->wait_ns_max = wait_ns;
+        }
+        pthread_cond_signal(&pool->not_full);
+        pthread_mutex_unlock(&pool->lock);
+
+        int result = task.handler(task.fd, task.arg);
+        if (task.registration != nullptr && result != PROACTOR_REARM) {
+            // stop watching before the completion gets a chance to close the fd
+            epoll_ctl(pool->epfd, EPOLL_CTL_DEL, task.fd, nullptr);
+        }
+        if (task.done != nullptr) {
+            task.done(task.fd, result, task.arg);
+        }
+        if (task.registration != nullptr) {
+            if (result == PROACTOR_REARM) {
+                struct epoll_event ev;
+                memset(&ev, 0, sizeof(ev));
+                ev.events = EPOLLIN | EPOLLONESHOT;
+                ev.data.ptr = task.registration;
+                epoll_ctl(pool->epfd, EPOLL_CTL_MOD, task.fd, &ev);
+            } else {
+                free(task.registration);
+            }
+        }
+
+        struct timespec done_at;
+        clock_gettime(CLOCK_MONOTONIC, &done_at);
+        pthread_mutex_lock(&pool->lock);
+        pool->busy_ns_total += elapsedNs(&picked_at, &done_at);
+        pool->tasks_completed++;
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+// turns readiness of watched fds into queued tasks
+static void* dispatcherLoop(void* arg)
+{
+    proactor_pool_t* pool = (proactor_pool_t*)arg;
+    struct epoll_event events[64];
+    while (pool->running) {
+        int nready = epoll_wait(pool->epfd, events, 64, -1);
+        if (nready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("proactor: epoll_wait");
+            break;
+        }
+        for (int i = 0; i < nready; i++) {
+            struct proactor_task* reg = (struct proactor_task*)events[i].data.ptr;
+            if (reg == nullptr) {
+                continue; // wakefd: stopping
+            }
+            // one-shot: the fd stays disarmed until its worker re-arms it
+            if (enqueueTask(pool, reg) == -1) {
+                return nullptr;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void* startProactorPool(int nworkers, int queue_depth)
+{
+    if (nworkers <= 0 || queue_depth <= 0) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    proactor_pool_t* pool = (proactor_pool_t*)calloc(1, sizeof(proactor_pool_t));
+    if (pool == nullptr) {
+        perror("Failed to allocate memory for proactor pool");
+        return nullptr;
+    }
+    pool->nworkers = nworkers;
+    pool->queue_depth = queue_depth;
+    pool->workers = (pthread_t*)calloc(nworkers, sizeof(pthread_t));
+    pool->queue = (struct proactor_task*)calloc(queue_depth, sizeof(struct proactor_task));
+    pool->epfd = epoll_create1(EPOLL_CLOEXEC);
+    pool->wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (pool->workers == nullptr || pool->queue == nullptr || pool->epfd == -1 || pool->wakefd == -1) {
+        perror("Failed to create proactor pool");
+        if (pool->epfd != -1) close(pool->epfd);
+        if (pool->wakefd != -1) close(pool->wakefd);
+        free(pool->workers);
+        free(pool->queue);
+        free(pool);
+        return nullptr;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    epoll_ctl(pool->epfd, EPOLL_CTL_ADD, pool->wakefd, &ev);
+
+    pthread_mutex_init(&pool->lock, nullptr);
+    pthread_cond_init(&pool->not_empty, nullptr);
+    pthread_cond_init(&pool->not_full, nullptr);
+    clock_gettime(CLOCK_MONOTONIC, &pool->started_at);
+    pool->running = 1;
+
+    for (int i = 0; i < nworkers; i++) {
+        if (pthread_create(&pool->workers[i], nullptr, workerLoop, pool) != 0) {
+            perror("pthread_create");
+            pool->nworkers = i;
+            stopProactorPool(pool);
+            return nullptr;
+        }
+    }
+    if (pthread_create(&pool->dispatcher, nullptr, dispatcherLoop, pool) != 0) {
+        perror("pthread_create");
+        pool->dispatcher = pthread_self();
+        stopProactorPool(pool);
+        return nullptr;
+    }
+    return pool;
+}
+
+int addFdToProactor(void* proactor, int fd, proactorHandler handler, proactorCompletion done, void* arg)
+{
+    proactor_pool_t* pool = (proactor_pool_t*)proactor;
+    if (pool == nullptr || fd < 0 || handler == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct proactor_task* reg = (struct proactor_task*)calloc(1, sizeof(struct proactor_task));
+    if (reg == nullptr) {
+        errno = ENOMEM;
+        return -1;
+    }
+    reg->fd = fd;
+    reg->registration = reg;
+    reg->handler = handler;
+    reg->done = done;
+    reg->arg = arg;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = reg;
+    if (epoll_ctl(pool->epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        free(reg);
+        return -1;
+    }
+    return 0;
+}
+
+int submitToProactor(void* proactor, int fd, proactorHandler handler, proactorCompletion done, void* arg)
+{
+    proactor_pool_t* pool = (proactor_pool_t*)proactor;
+    if (pool == nullptr || handler == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct proactor_task task;
+    memset(&task, 0, sizeof(task));
+    task.fd = fd;
+    task.handler = handler;
+    task.done = done;
+    task.arg = arg;
+    return enqueueTask(pool, &task);
+}
+
+int getProactorMetrics(void* proactor, proactor_metrics_t* metrics)
+{
+    proactor_pool_t* pool = (proactor_pool_t*)proactor;
+    if (pool == nullptr || metrics == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t uptime_ns = elapsedNs(&pool->started_at, &now);
+
+    pthread_mutex_lock(&pool->lock);
+    // wait_ns_total covers every dequeued task, the ones still running included
+    uint64_t dequeued = pool->tasks_dequeued;
+    metrics->tasks_completed = pool->tasks_completed;
+    metrics->queue_full_waits = pool->queue_full_waits;
+    metrics->avg_queue_wait_us = dequeued ? (double)pool->wait_ns_total / dequeued / 1000.0 : 0.0;
+    metrics->max_queue_wait_us = (double)pool->wait_ns_max / 1000.0;
+    metrics->utilization = uptime_ns ? (double)pool->busy_ns_total / ((double)uptime_ns * pool->nworkers) : 0.0;
+    metrics->queued = pool->count;
+    metrics->workers = pool->nworkers;
+    metrics->queue_depth = pool->queue_depth;
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+int stopProactorPool(void* proactor)
+{
+    proactor_pool_t* pool = (proactor_pool_t*)proactor;
+    if (pool == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->running = 0;
+    pthread_cond_broadcast(&pool->not_empty);
+    pthread_cond_broadcast(&pool->not_full);
+    pthread_mutex_unlock(&pool->lock);
+
+    uint64_t one = 1;
+    if (write(pool->wakefd, &one, sizeof(one)) == -1) {
+        perror("proactor: wake dispatcher");
+    }
+    if (!pthread_equal(pool->dispatcher, pthread_self())) {
+        pthread_join(pool->dispatcher, nullptr);
+    }
+    for (int i = 0; i < pool->nworkers; i++) {
+        pthread_join(pool->workers[i], nullptr);
+    }
+
+    close(pool->epfd);
+    close(pool->wakefd);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->not_empty);
+    pthread_cond_destroy(&pool->not_full);
+    free(pool->workers);
+    free(pool->queue);
+    free(pool);
+    return 0;
+}
@@ -7,6 +7,7 @@
 #define REACTOR_H
 
 #include <sys/select.h>
+#include <sys/epoll.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -21,28 +22,64 @@
 typedef void (*reactorFunc)(int fd);
 
 /**
- * @brief Reactor structure for managing file descriptors
+ * @brief I/O multiplexing backend used by a reactor
+ *
+ * REACTOR_SELECT scans every fd up to max_fd on each wakeup and is limited to
+ * FD_SETSIZE descriptors. REACTOR_EPOLL dispatches only the ready fds and has
+ * no descriptor cap.
  */
-#define MAX_FDS 1024  /* Maximum number of file descriptors to manage */
+typedef enum {
+    REACTOR_SELECT = 0,
+    REACTOR_EPOLL = 1
+} reactor_backend_t;
 
+#define REACTOR_INITIAL_FDS 64  /* Initial size of the callback table, grown on demand */
 
+/**
+ * @brief Reactor structure for managing file descriptors
+ */
 struct reactor {
-    fd_set fds;       /* Master set of file descriptors */
-    int max_fd;              /* Highest file descriptor value */
+    reactor_backend_t backend; /* Backend chosen at startReactor time */
+    fd_set fds;       /* Master set of file descriptors (select backend) */
+    fd_set wfds;             /* File descriptors watched for writability (select backend) */
+    int max_fd;              /* Highest file descriptor value (select backend) */
     int running;             /* Flag to control reactor loop */
-    reactorFunc r_funcs[MAX_FDS]; /* Array of callback functions */
-
+    int epfd;                /* epoll instance (epoll backend) */
+    int nfds;                /* Number of registered file descriptors */
+    reactorFunc *r_funcs;    /* Growable table of callback functions, indexed by fd */
+    reactorFunc *w_funcs;    /* Writability callbacks, indexed by fd, null while not watched */
+    unsigned char *paused;   /* Nonzero for fds whose readability is not watched, indexed by fd */
+    int capacity;            /* Number of slots in r_funcs, w_funcs and paused */
+    struct epoll_event *events; /* Ready list filled by epoll_wait (epoll backend) */
+    int max_events;          /* Number of slots in events */
 };
 
 typedef struct reactor reactor_t;
 
 /**
- * @brief Creates and starts a new reactor
+ * @brief Creates and starts a new reactor using the select backend
  *
  * @return pointer to the created reactor or nullptr on failure
  */
 void* startReactor();
 
+/**
+ * @brief Creates and starts a new reactor using the given backend
+ *
+ * @param backend REACTOR_SELECT or REACTOR_EPOLL
+ * @return pointer to the created reactor or nullptr on failure
+ */
+void* startReactorWithBackend(reactor_backend_t backend);
+
+/**
+ * @brief Parses a backend name ("select" or "epoll")
+ *
+ * @param name backend name
+ * @param backend output backend
+ * @return 0 on success, -1 if the name is unknown
+ */
+int parseReactorBackend(const char* name, reactor_backend_t* backend);
+
 /**
  * @brief Adds a file descriptor to the reactor for monitoring
  *
@@ -58,10 +95,48 @@ int addFdToReactor(void* reactor, int fd, reactorFunc func);
  *
  * @param reactor pointer to the reactor
  * @param fd file descriptor to remove
- * @return updated max_fd on success, -1 when last fd was removed or failure occurred
+ * @return updated max_fd (select) or number of registered fds (epoll) on success,
+ *         -1 when last fd was removed or failure occurred
  */
 int removeFdFromReactor(void* reactor, int fd);
 
+/**
+ * @brief Watches a file descriptor already added with addFdToReactor for writability too
+ *
+ * Meant for non-blocking sockets with output queued: func runs whenever fd can take more
+ * bytes, so it should be removed again once the queue is empty. An error or hangup on fd is
+ * reported to func as well, also while reading is paused.
+ *
+ * @param reactor pointer to the reactor
+ * @param fd file descriptor to watch
+ * @param func callback function to execute when fd is writable
+ * @return 0 on success, -1 on failure
+ */
+int addWriteFdToReactor(void* reactor, int fd, reactorFunc func);
+
+/**
+ * @brief Stops watching a file descriptor for writability, its readability is kept
+ *
+ * @param reactor pointer to the reactor
+ * @param fd file descriptor to stop watching
+ * @return 0 on success, -1 on failure
+ */
+int removeWriteFdFromReactor(void* reactor, int fd);
+
+/**
+ * @brief Pauses or resumes watching a file descriptor for readability
+ *
+ * A paused fd keeps its callback and its write watch; the data the peer sends meanwhile waits
+ * in the kernel, which in time makes the peer's sends block. This is how a server stops taking
+ * requests from a client that does not read its replies.
+ *
+ * @param reactor pointer to the reactor
+ * @param fd file descriptor added with addFdToReactor
+ * @param reading 0 to pause, nonzero to resume
+ * @return 0 on success, -1 on failure
+ */
+int setFdReading(void* reactor, int fd, int reading);
+
 /**
  * @brief Stops the reactor and frees associated resources
  *
@@ -75,11 +150,22 @@ int stopReactor(void* reactor);
  *
  * This function enters a blocking loop that monitors registered file
  * descriptors for activity and calls their associated callback functions
- * when activity is detected. The loop continues until stopReactor is called.
+ * when activity is detected. The loop continues until breakReactor is called.
  *
  * @param reactor pointer to the reactor
  * @return 0 on success, -1 on failure
  */
 int runReactor(void* reactor);
 
+/**
+ * @brief Makes runReactor return once the callbacks of the current wakeup are done
+ *
+ * Unlike stopReactor it frees nothing, so a callback on the reactor's own thread may call it;
+ * stopReactor follows once runReactor has returned.
+ *
+ * @param reactor pointer to the reactor
+ * @return 0 on success, -1 on failure
+ */
+int breakReactor(void* reactor);
+
 #endif /* REACTOR_H */
\ No newline at end of file
@@ -8,13 +8,26 @@
 
 /*
 * struct reactor {
-    fd_set fds;       / Master set of file descriptors /
-    int max_fd;              / Highest file descriptor value /
+    reactor_backend_t backend; / Backend chosen at startReactor time /
+    fd_set fds;       / Master set of file descriptors (select backend) /
+    fd_set wfds;             / File descriptors watched for writability (select backend) /
+    int max_fd;              / Highest file descriptor value (select backend) /
     int running;             / Flag to control reactor loop /
-    reactorFunc r_funcs[MAX_FDS]; / Array of callback functions /
+    int epfd;                / epoll instance (epoll backend) /
+    int nfds;                / Number of registered file descriptors /
+    reactorFunc *r_funcs;    / Growable table of callback functions, indexed by fd /
+    reactorFunc *w_funcs;    / Writability callbacks, indexed by fd, null while not watched /
+    unsigned char *paused;   / Nonzero for fds whose readability is not watched, indexed by fd /
+    int capacity;            / Number of slots in r_funcs, w_funcs and paused /
+    struct epoll_event *events; / Ready list filled by epoll_wait (epoll backend) /
+    int max_events;          / Number of slots in events /
 };
  */
 void * startReactor() {
+    return startReactorWithBackend(REACTOR_SELECT);
+}
+
+void * startReactorWithBackend(reactor_backend_t backend) {
     reactor_t* reactor = (reactor_t*)malloc(sizeof(reactor_t));
     if (reactor == nullptr) {
         perror("Failed to allocate memory for reactor");
@@ -23,54 +36,263 @@ void * startReactor() {
 
     // Initialize the reactor structure
     FD_ZERO(&reactor->fds);
+    FD_ZERO(&reactor->wfds);
+    reactor->backend = backend;
     reactor->max_fd = -1;
     reactor->running = 1;
-    memset(reactor->r_funcs, 0, sizeof(reactor->r_funcs));
+    reactor->epfd = -1;
+    reactor->nfds = 0;
+    reactor->capacity = REACTOR_INITIAL_FDS;
+    reactor->r_funcs = (reactorFunc*)calloc(reactor->capacity, sizeof(reactorFunc));
+    reactor->w_funcs = (reactorFunc*)calloc(reactor->capacity, sizeof(reactorFunc));
+    reactor->paused = (unsigned char*)calloc(reactor->capacity, sizeof(unsigned char));
+    reactor->max_events = 0;
+    reactor->events = nullptr;
+    if (reactor->r_funcs == nullptr || reactor->w_funcs == nullptr || reactor->paused == nullptr) {
+        perror("Failed to allocate memory for reactor callbacks");
+        free(reactor->r_funcs);
+        free(reactor->w_funcs);
+        free(reactor->paused);
+        free(reactor);
+        return nullptr;
+    }
+
+    if (backend == REACTOR_EPOLL) {
+        reactor->epfd = epoll_create1(EPOLL_CLOEXEC);
+        reactor->max_events = REACTOR_INITIAL_FDS;
+        reactor->events = (struct epoll_event*)malloc(reactor->max_events * sizeof(struct epoll_event));
+        if (reactor->epfd == -1 || reactor->events == nullptr) {
+            perror("Failed to create epoll instance");
+            if (reactor->epfd != -1) {
+                close(reactor->epfd);
+            }
+            free(reactor->events);
+            free(reactor->r_funcs);
+            free(reactor->w_funcs);
+            free(reactor->paused);
+            free(reactor);
+            return nullptr;
+        }
+    }
 
     return reactor;
 }
 
+int parseReactorBackend(const char *name, reactor_backend_t *backend) {
+    if (name == nullptr || backend == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (strcmp(name, "select") == 0) {
+        *backend = REACTOR_SELECT;
+        return 0;
+    }
+    if (strcmp(name, "epoll") == 0) {
+        *backend = REACTOR_EPOLL;
+        return 0;
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+// Grows the callback tables (and the epoll ready list) so that fd fits
+static int growReactor(reactor_t* r, int fd) {
+    if (fd >= r->capacity) {
+        int new_capacity = r->capacity;
+        while (fd >= new_capacity) {
+            new_capacity *= 2;
+        }
+        reactorFunc* funcs = (reactorFunc*)realloc(r->r_funcs, new_capacity * sizeof(reactorFunc));
+        if (funcs == nullptr) {
+            return -1;
+        }
+        memset(funcs + r->capacity, 0, (new_capacity - r->capacity) * sizeof(reactorFunc));
+        r->r_funcs = funcs;
+        funcs = (reactorFunc*)realloc(r->w_funcs, new_capacity * sizeof(reactorFunc));
+        if (funcs == nullptr) {
+            return -1;
+        }
+        memset(funcs + r->capacity, 0, (new_capacity - r->capacity) * sizeof(reactorFunc));
+        r->w_funcs = funcs;
+        unsigned char* paused = (unsigned char*)realloc(r->paused, new_capacity);
+        if (paused == nullptr) {
+            return -1;
+        }
+        memset(paused + r->capacity, 0, new_capacity - r->capacity);
+        r->paused = paused;
+        r->capacity = new_capacity;
+    }
+    if (r->backend == REACTOR_EPOLL && r->nfds >= r->max_events) {
+        int new_max = r->max_events * 2;
+        struct epoll_event* events = (struct epoll_event*)realloc(r->events, new_max * sizeof(struct epoll_event));
+        if (events == nullptr) {
+            return -1;
+        }
+        r->events = events;
+        r->max_events = new_max;
+    }
+    return 0;
+}
+
+// Registers fd with epoll (op EPOLL_CTL_ADD) or updates it (EPOLL_CTL_MOD) to the events its
+// read and write watches ask for
+static int updateEpoll(reactor_t* r, int fd, int op) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    if (r->r_funcs[fd] != nullptr && !r->paused[fd]) {
+        ev.events |= EPOLLIN;
+    }
+    if (r->w_funcs[fd] != nullptr) {
+        ev.events |= EPOLLOUT;
+    }
+    ev.data.fd = fd;
+    return epoll_ctl(r->epfd, op, fd, &ev);
+}
+
 int addFdToReactor(void *reactor, int fd, reactorFunc func) {
     reactor_t* r = (reactor_t*)reactor;
 
-    if (r == nullptr || fd < 0 || fd >= MAX_FDS || func == nullptr) {
+    if (r == nullptr || fd < 0 || func == nullptr) {
         errno = EINVAL;
         return -1;
     }
+    if (r->backend == REACTOR_SELECT && fd >= FD_SETSIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (growReactor(r, fd) == -1) {
+        errno = ENOMEM;
+        return -1;
+    }
 
-    // Add the file descriptor to the set
-    FD_SET(fd, &r->fds);
+    // Store the callback function; a new fd starts reading and not watched for writability
+    reactorFunc previous = r->r_funcs[fd];
+    if (previous == nullptr) {
+        r->w_funcs[fd] = nullptr;
+        r->paused[fd] = 0;
+    }
+    r->r_funcs[fd] = func;
 
-    // Update max_fd if necessary
-    if (fd > r->max_fd) {
-        r->max_fd = fd;
+    if (r->backend == REACTOR_EPOLL) {
+        if (updateEpoll(r, fd, previous == nullptr ? EPOLL_CTL_ADD : EPOLL_CTL_MOD) == -1) {
+            r->r_funcs[fd] = previous;
+            return -1;
+        }
+    } else {
+        // Add the file descriptor to the set
+        if (!r->paused[fd]) {
+            FD_SET(fd, &r->fds);
+        }
+
+        // Update max_fd if necessary
+        if (fd > r->max_fd) {
+            r->max_fd = fd;
+        }
     }
 
-    // Store the callback function
-    r->r_funcs[fd] = func;
+    if (previous == nullptr) {
+        r->nfds++;
+    }
 
     return 0;
 }
 
+int addWriteFdToReactor(void *reactor, int fd, reactorFunc func) {
+    reactor_t* r = (reactor_t*)reactor;
+
+    if (r == nullptr || fd < 0 || fd >= r->capacity || r->r_funcs[fd] == nullptr || func == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    reactorFunc previous = r->w_funcs[fd];
+    r->w_funcs[fd] = func;
+    if (r->backend == REACTOR_EPOLL) {
+        if (previous == nullptr && updateEpoll(r, fd, EPOLL_CTL_MOD) == -1) {
+            r->w_funcs[fd] = previous;
+            return -1;
+        }
+    } else {
+        FD_SET(fd, &r->wfds);
+    }
+    return 0;
+}
+
+int removeWriteFdFromReactor(void *reactor, int fd) {
+    reactor_t* r = (reactor_t*)reactor;
+
+    if (r == nullptr || fd < 0 || fd >= r->capacity || r->r_funcs[fd] == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (r->w_funcs[fd] == nullptr) {
+        return 0;
+    }
+
+    r->w_funcs[fd] = nullptr;
+    if (r->backend == REACTOR_EPOLL) {
+        return updateEpoll(r, fd, EPOLL_CTL_MOD);
+    }
+    FD_CLR(fd, &r->wfds);
+    return 0;
+}
+
+int setFdReading(void *reactor, int fd, int reading) {
+    reactor_t* r = (reactor_t*)reactor;
+
+    if (r == nullptr || fd < 0 || fd >= r->capacity || r->r_funcs[fd] == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!r->paused[fd] == !!reading) {
+        return 0;
+    }
+
+    r->paused[fd] = !reading;
+    if (r->backend == REACTOR_EPOLL) {
+        return updateEpoll(r, fd, EPOLL_CTL_MOD);
+    }
+    if (reading) {
+        FD_SET(fd, &r->fds);
+    } else {
+        FD_CLR(fd, &r->fds);
+    }
+    return 0;
+}
+
 int removeFdFromReactor(void *reactor, int fd) {
     reactor_t* r = (reactor_t*)reactor;
 
-    if (r == nullptr || fd < 0 || fd >= MAX_FDS) {
+    if (r == nullptr || fd < 0 || fd >= r->capacity) {
         errno = EINVAL;
         return -1;
     }
 
-    // Clear the file descriptor from the set
+    if (r->r_funcs[fd] != nullptr) {
+        r->nfds--;
+    }
+    // Clear the callbacks
+    r->r_funcs[fd] = nullptr;
+    r->w_funcs[fd] = nullptr;
+    r->paused[fd] = 0;
+
+    if (r->backend == REACTOR_EPOLL) {
+        // The fd may already be closed, in which case the kernel dropped it for us
+        epoll_ctl(r->epfd, EPOLL_CTL_DEL, fd, nullptr);
+        std::cout<<"removed client from socket "<<fd<<". registered sockets: "<<r->nfds<<"\n";
+        return r->nfds > 0 ? r->nfds : -1;
+    }
+
+    // Clear the file descriptor from the sets
     FD_CLR(fd, &r->fds);
+    FD_CLR(fd, &r->wfds);
 
-    // Clear the callback
-    r->r_funcs[fd] = nullptr;
     // Recalculate max_fd if necessary
     if (fd == r->max_fd) {
-        // Start from the previous max_fd and search downward
+        // Start from the previous max_fd and search downward; a paused fd is not in the read set
         r->max_fd = -1;
         for (int i = fd - 1; i >= 0; i--) {
-            if (FD_ISSET(i, &r->fds)) {// Found the new highest fd
+            if (r->r_funcs[i] != nullptr) {// Found the new highest fd
                 r->max_fd = i;
                 break;
             }
@@ -80,19 +302,17 @@ int removeFdFromReactor(void *reactor, int fd) {
     return r->max_fd;
 }
 
-int runReactor(void *reactor) {
-    reactor_t* r = (reactor_t*)reactor;
-
-    if (r == nullptr) {
-        errno = EINVAL;
-        return -1;
-    }
-
+// select backend: scan every fd up to max_fd
+static int runSelectLoop(reactor_t* r) {
     while (r->running) {
         fd_set read_fds = r->fds;  // to preserve the master set
+        fd_set write_fds = r->wfds;
 
         // Wait for activity on one of the sockets
-        if (select(r->max_fd + 1, &read_fds, nullptr, nullptr, nullptr) == -1) {
+        if (select(r->max_fd + 1, &read_fds, &write_fds, nullptr, nullptr) == -1) {
+            if (errno == EINTR) {
+                continue;  // a signal handler ran; it wakes the loop through an fd if it must end
+            }
             perror("runReactor: select");
             return -1;
         }
@@ -104,12 +324,66 @@ int runReactor(void *reactor) {
                     r->r_funcs[i](i);  // Call the callback function
                 }
             }
+            // The read callback may have removed i
+            if (FD_ISSET(i, &write_fds) && r->w_funcs[i] != nullptr) {
+                r->w_funcs[i](i);
+            }
         }
     }
+    return 0;
+}
+
+// epoll backend: dispatch only the fds reported ready
+static int runEpollLoop(reactor_t* r) {
+    while (r->running) {
+        int nready = epoll_wait(r->epfd, r->events, r->max_events, -1);
+        if (nready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("runReactor: epoll_wait");
+            return -1;
+        }
+
+        for (int i = 0; i < nready && r->running; i++) {
+            int fd = r->events[i].data.fd;
+            uint32_t events = r->events[i].events;
+            // A previous callback in this batch may have removed fd; errors go to both watches
+            if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && r->r_funcs[fd] != nullptr && !r->paused[fd]) {
+                r->r_funcs[fd](fd);  // Call the callback function
+            }
+            if ((events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) && r->w_funcs[fd] != nullptr) {
+                r->w_funcs[fd](fd);
+            }
+        }
+    }
+    return 0;
+}
 
+int breakReactor(void *reactor) {
+    reactor_t* r = (reactor_t*)reactor;
+    if (r == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+    r->running = 0;
     return 0;
 }
 
+int runReactor(void *reactor) {
+    reactor_t* r = (reactor_t*)reactor;
+
+    if (r == nullptr) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (r->backend == REACTOR_EPOLL) {
+        return runEpollLoop(r);
+    }
+    return runSelectLoop(r);
+}
+
 int stopReactor(void *reactor) {
     reactor_t* r = (reactor_t*)reactor;
     if (r == nullptr) {
@@ -118,8 +392,14 @@ int stopReactor(void *reactor) {
     }
     r->running = 0;
     FD_ZERO(&r->fds);
-    memset(r->r_funcs, 0, sizeof(r->r_funcs));
+    FD_ZERO(&r->wfds);
+    if (r->epfd != -1) {
+        close(r->epfd);
+    }
+    free(r->events);
+    free(r->r_funcs);
+    free(r->w_funcs);
+    free(r->paused);
     free(r);
     return 0;
 }
-
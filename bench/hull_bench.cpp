@@ -0,0 +1,505 @@
+//
+// Benchmarks for the hull engines of ConvexHullCalculator.
+//
+// Usage: ./hull_bench threads [n] [max_threads]
+//        ./hull_bench chan [n]
+//        ./hull_bench engines [n]
+//        ./hull_bench kernels [n]
+//        ./hull_bench coords [n]
+//        ./hull_bench churn [n]
+//        ./hull_bench dups [n]
+//        ./hull_bench files [n]
+//        ./hull_bench parse [n]
+//        ./hull_bench allocs [n]
+//        ./hull_bench wire [n]
+//
+
+#include "../utils/ConvexHullCalculator.hpp"
+#include "../utils/Session.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <new>
+#include <thread>
+
+// Heap allocations of the process so far, for the allocs benchmark
+static std::atomic<size_t> allocations(0);
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+// Uniform points in a square: almost all of them are interior
+static std::vector<Point> uniformSquare(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> coord(-1e6, 1e6);
+    std::vector<Point> points(n);
+    for (Point &p: points) {
+        p = Point(coord(rng), coord(rng));
+    }
+    return points;
+}
+
+// n points with exactly h hull vertices: a regular h-gon, the rest inside its incircle
+static std::vector<Point> knownHull(size_t n, size_t h, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<Point> points;
+    points.reserve(n);
+    double inner = 0.99 * cos(M_PI / h);
+    for (size_t i = 0; i < n; ++i) {
+        double angle = 2 * M_PI * unit(rng);
+        if (i < h) {
+            angle = 2 * M_PI * i / h;
+            points.emplace_back(1e6 * cos(angle), 1e6 * sin(angle));
+        } else {
+            double r = inner * sqrt(unit(rng));
+            points.emplace_back(1e6 * r * cos(angle), 1e6 * r * sin(angle));
+        }
+    }
+    std::shuffle(points.begin(), points.end(), rng);
+    return points;
+}
+
+// Milliseconds for the best of runs hull computations, over points loaded into a PointStore once
+static double timeHull(ConvexHullCalculator &calc, const std::vector<Point> &points, int runs, double &area) {
+    PointStore store(points);
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        area = calc.calculateArea(calc.computeHull(store.span()));
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+// Milliseconds for the best of runs hull computations over points stored as Coord
+template <typename Coord>
+static double timeCoords(ConvexHullCalculator &calc, const std::vector<Point> &points, int runs, size_t &hullSize) {
+    BasicPointStore<Coord> store(points);
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        hullSize = calc.computeHull(store.span()).size();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ms);
+    }
+    return best;
+}
+
+// Speedup of the parallel path against the serial one for 1..maxThreads threads
+static void benchThreads(size_t n, unsigned maxThreads) {
+    std::vector<Point> points = uniformSquare(n, 1);
+    printf("threads speedup, n = %zu, %u hardware threads\n", n, std::thread::hardware_concurrency());
+    printf("%8s %8s %12s %10s %10s\n", "prefilt", "threads", "ms", "speedup", "area ok");
+    for (int prefilter = 0; prefilter <= 1; ++prefilter) {
+        ConvexHullCalculator calc;
+        calc.setEngine(HullEngine::MonotoneChain);
+        calc.setPrefilter(prefilter);
+        calc.setParallelThreshold(0);
+        calc.setParallelThreads(1);
+        double serialArea;
+        double serial = timeHull(calc, points, 3, serialArea);
+        for (unsigned t = 1; t <= maxThreads; ++t) {
+            calc.setParallelThreads(t);
+            double area;
+            double ms = timeHull(calc, points, 3, area);
+            printf("%8s %8u %12.2f %10.2f %10s\n", prefilter ? "on" : "off", t, ms, serial / ms,
+                   area == serialArea ? "yes" : "NO");
+        }
+    }
+}
+
+// Chan against Graham and monotone chain for growing hull sizes, prefilter off
+static void benchChan(size_t n) {
+    static const HullEngine engines[] = {HullEngine::Graham, HullEngine::MonotoneChain, HullEngine::Chan};
+    printf("engines against hull size, n = %zu, prefilter off\n", n);
+    printf("%10s %12s %12s %12s\n", "h", "graham ms", "monotone ms", "chan ms");
+    for (size_t h = 8; h <= n; h *= 4) {
+        std::vector<Point> points = knownHull(n, h, 2);
+        printf("%10zu", h);
+        for (HullEngine engine: engines) {
+            ConvexHullCalculator calc;
+            calc.setEngine(engine);
+            calc.setPrefilter(false);
+            calc.setParallelThreads(1);
+            double area;
+            printf(" %12.2f", timeHull(calc, points, 3, area));
+        }
+        printf("\n");
+    }
+}
+
+// Every engine and the adaptive selector on several point distributions
+static void benchEngines(size_t n) {
+    static const HullEngine engines[] = {HullEngine::Graham, HullEngine::MonotoneChain, HullEngine::Chan,
+                                         HullEngine::Quickhull, HullEngine::Auto};
+    std::vector<std::pair<const char *, std::vector<Point> > > inputs;
+    inputs.emplace_back("square", uniformSquare(n, 3));
+    inputs.emplace_back("h=16", knownHull(n, 16, 4));
+    inputs.emplace_back("circle", knownHull(n, n, 5));
+    std::vector<Point> sorted = uniformSquare(n, 6);
+    std::sort(sorted.begin(), sorted.end(), [](const Point &p, const Point &q) {
+        return p.x < q.x || (p.x == q.x && p.y < q.y);
+    });
+    inputs.emplace_back("sorted", sorted);
+    inputs.emplace_back("tiny", uniformSquare(12, 7));
+
+    printf("engines on n = %zu (tiny: 12), ms\n", n);
+    for (int prefilter = 0; prefilter <= 1; ++prefilter) {
+        printf("prefilter %s\n%8s %10s %10s %10s %10s %10s  %s\n", prefilter ? "on" : "off", "input", "graham",
+               "monotone", "chan", "quickhull", "auto", "auto picked");
+        for (auto &input: inputs) {
+            printf("%8s", input.first);
+            ConvexHullCalculator calc;
+            for (HullEngine engine: engines) {
+                calc.setEngine(engine);
+                calc.setPrefilter(prefilter);
+                calc.setParallelThreads(1);
+                double area;
+                printf(" %10.3f", timeHull(calc, input.second, 3, area));
+            }
+            printf("  %s\n", ConvexHullCalculator::engineName(calc.getStats().engine));
+        }
+    }
+}
+
+// Every coordinate type on integer inputs, with the engine the selector picks and with the
+// monotone chain, prefilter on
+static void benchCoords(size_t n) {
+    std::vector<std::pair<const char *, std::vector<Point> > > inputs;
+    inputs.emplace_back("square", uniformSquare(n, 9));
+    inputs.emplace_back("circle", knownHull(n, n, 10));
+    for (auto &input: inputs) {
+        for (Point &p: input.second) {
+            p = Point(std::round(p.x), std::round(p.y));
+        }
+    }
+
+    printf("coordinate types on n = %zu integer points, ms (hull vertices)\n", n);
+    printf("%8s %10s %22s %22s %22s %22s\n", "input", "engine", "double (16 B/pt)", "float (8 B/pt)",
+           "int32 (8 B/pt)", "int64 (16 B/pt)");
+    for (auto &input: inputs) {
+        for (HullEngine engine: {HullEngine::Auto, HullEngine::MonotoneChain}) {
+            ConvexHullCalculator calc;
+            calc.setEngine(engine);
+            calc.setParallelThreads(1);
+            size_t h[4];
+            double ms[4];
+            ms[0] = timeCoords<double>(calc, input.second, 3, h[0]);
+            ms[1] = timeCoords<float>(calc, input.second, 3, h[1]);
+            ms[2] = timeCoords<int32_t>(calc, input.second, 3, h[2]);
+            ms[3] = timeCoords<int64_t>(calc, input.second, 3, h[3]);
+            printf("%8s %10s", input.first, ConvexHullCalculator::engineName(engine));
+            for (int t = 0; t < 4; ++t) {
+                printf(" %12.3f (%7zu)", ms[t], h[t]);
+            }
+            printf("\n");
+        }
+    }
+}
+
+// Microseconds per Newpoint and per Removepoint of a random earlier point on a graph of n points
+static void benchChurn(size_t n) {
+    std::vector<Point> points = uniformSquare(n, 11);
+    std::vector<std::string> lines;
+    for (const Point &p: points) {
+        lines.push_back(std::to_string(p.x) + "," + std::to_string(p.y));
+    }
+    ConvexHullCalculator calc;
+    calc.commandNewGraph(static_cast<int>(n), lines);
+    calc.commandCalculateHull();
+
+    std::mt19937_64 rng(12);
+    const size_t ops = 20000;
+    double addUs = 0, removeUs = 0;
+    size_t removed = 0;
+    for (size_t i = 0; i < ops; ++i) {
+        std::string added = lines[rng() % n];
+        auto start = std::chrono::steady_clock::now();
+        calc.processCommand("Newpoint " + added);
+        auto middle = std::chrono::steady_clock::now();
+        removed += calc.processCommand("Removepoint " + lines[rng() % n]) == "Point removed.";
+        auto end = std::chrono::steady_clock::now();
+        addUs += std::chrono::duration<double, std::micro>(middle - start).count();
+        removeUs += std::chrono::duration<double, std::micro>(end - middle).count();
+    }
+    printf("churn on n = %zu: %.2f us per Newpoint, %.2f us per Removepoint (%zu of %zu found)\n", n,
+           addUs / ops, removeUs / ops, removed, ops);
+}
+
+// Newgraph then CH on the q2 generate_data points (i % 830, i % 365), with and without dedup
+static void benchDups(size_t n) {
+    std::vector<std::string> lines;
+    for (size_t i = 1; i <= n; ++i) {
+        lines.push_back(std::to_string(i % 830) + "," + std::to_string(i % 365));
+    }
+    for (bool dedup: {false, true}) {
+        ConvexHullCalculator calc;
+        calc.setDedup(dedup);
+        auto start = std::chrono::steady_clock::now();
+        calc.commandNewGraph(static_cast<int>(n), lines);
+        auto loaded = std::chrono::steady_clock::now();
+        double area = calc.commandCalculateHull();
+        auto end = std::chrono::steady_clock::now();
+        printf("dedup %-3s: load %7.1f ms, CH %7.1f ms, %zu distinct of %zu, area %.1f\n", dedup ? "on" : "off",
+               std::chrono::duration<double, std::milli>(loaded - start).count(),
+               std::chrono::duration<double, std::milli>(end - loaded).count(), calc.distinctSize(), calc.size(),
+               area);
+    }
+}
+
+// Newgraph from n text lines: one string per line, against one buffer of all the lines parsed in
+// place, with and without the plain decimal fast path
+static void benchParse(size_t n) {
+    std::vector<Point> points = uniformSquare(n, 14);
+    std::vector<std::string> lines;
+    std::string buffer;
+    lines.reserve(n);
+    for (const Point &p: points) {
+        lines.push_back(std::to_string(p.x) + "," + std::to_string(p.y));
+        buffer += lines.back();
+        buffer += '\n';
+    }
+    ConvexHullCalculator calc;
+    auto start = std::chrono::steady_clock::now();
+    calc.commandNewGraph(static_cast<int>(n), lines);
+    auto end = std::chrono::steady_clock::now();
+    double area = calc.commandCalculateHull();
+    printf("n = %zu: lines %.1f ms", n, std::chrono::duration<double, std::milli>(end - start).count());
+    for (bool fast: {false, true}) {
+        setFastDecimalParsing(fast);
+        start = std::chrono::steady_clock::now();
+        LineParseResult result = calc.commandNewGraph(static_cast<int>(n), buffer);
+        end = std::chrono::steady_clock::now();
+        printf(", buffer%s %.1f ms", fast ? " fast" : "", std::chrono::duration<double, std::milli>(end - start).count());
+        if (result.points != n || calc.commandCalculateHull() != area) {
+            printf(" (mismatch)");
+        }
+    }
+    printf("\n");
+}
+
+// Heap allocations per command of a session in steady state, after one warm-up round has built
+// the indexes and grown the reply buffer. Fails unless every command allocates nothing
+static bool benchAllocs(size_t n) {
+    std::vector<Point> points = uniformSquare(n, 15);
+    std::vector<std::string> lines;
+    for (const Point &p: points) {
+        lines.push_back(std::to_string(p.x) + "," + std::to_string(p.y));
+    }
+    SharedGraph graph;
+    graph.calculator.commandNewGraph(static_cast<int>(n), lines);
+    Session session(&graph);
+    // an interior point added and removed again, so the graph ends each round as it started
+    const char *commands[] = {"CH", "Newpoint 0.5,0.25", "CH", "Countrect -1000,-1000,1000,1000",
+                              "Countcircle 0,0,5000", "Removepoint 0.5,0.25", "Version", "Engine", "Stats",
+                              "Removepoint 7,7", "Newpoint bad", "Nonsense", "help"};
+    const size_t count = sizeof commands / sizeof commands[0];
+    const size_t rounds = 1000;
+    size_t perCommand[count] = {};
+    for (size_t round = 0; round <= rounds; ++round) {
+        for (size_t i = 0; i < count; ++i) {
+            size_t before = allocations.load(std::memory_order_relaxed);
+            session.handleLine(commands[i]);
+            session.pendingOutput().clear();
+            if (round > 0) {
+                perCommand[i] += allocations.load(std::memory_order_relaxed) - before;
+            }
+        }
+    }
+    bool clean = true;
+    for (size_t i = 0; i < count; ++i) {
+        printf("%-36s %.2f allocations per command\n", commands[i], static_cast<double>(perCommand[i]) / rounds);
+        clean = clean && perCommand[i] == 0;
+    }
+    printf("%s\n", clean ? "steady state is allocation-free" : "some commands allocate");
+    return clean;
+}
+
+// Loading n points from Newgraph text lines against Savegraph and Loadgraph of a graph file
+static void benchFiles(size_t n) {
+    std::vector<Point> points = uniformSquare(n, 13);
+    std::vector<std::string> lines;
+    lines.reserve(n);
+    for (const Point &p: points) {
+        lines.push_back(std::to_string(p.x) + "," + std::to_string(p.y));
+    }
+    const std::string path = "hull_bench.graph";
+    std::string error;
+    ConvexHullCalculator text, binary;
+
+    auto start = std::chrono::steady_clock::now();
+    text.commandNewGraph(static_cast<int>(n), lines);
+    auto parsed = std::chrono::steady_clock::now();
+    bool saved = text.commandSaveGraph(path, error);
+    auto written = std::chrono::steady_clock::now();
+    bool loaded = saved && binary.commandLoadGraph(path, error);
+    auto end = std::chrono::steady_clock::now();
+    remove(path.c_str());
+    if (!loaded) {
+        fprintf(stderr, "graph file failed: %s\n", error.c_str());
+        return;
+    }
+    printf("n = %zu: Newgraph text %.1f ms, Savegraph %.1f ms, Loadgraph %.1f ms, same area: %s\n", n,
+           std::chrono::duration<double, std::milli>(parsed - start).count(),
+           std::chrono::duration<double, std::milli>(written - parsed).count(),
+           std::chrono::duration<double, std::milli>(end - written).count(),
+           text.commandCalculateHull() == binary.commandCalculateHull() ? "yes" : "no");
+}
+
+// Copies bytes into the session's input as a receive would and handles them
+static void receive(Session &session, const std::string &bytes) {
+    LineBuffer &input = session.pendingInput();
+    std::memcpy(input.prepare(bytes.size()), bytes.data(), bytes.size());
+    input.commit(bytes.size());
+    session.handleInput();
+}
+
+// Uploading n points to a session: Newgraph and n text lines against one binary Points message
+static void benchWire(size_t n) {
+    std::vector<Point> points = uniformSquare(n, 16);
+    std::string text = "Newgraph " + std::to_string(n) + "\n";
+    for (Point &p: points) {
+        std::string x = std::to_string(p.x), y = std::to_string(p.y);
+        text += x + "," + y + "\n";
+        // the binary upload carries the same rounded values
+        p = Point(std::stod(x), std::stod(y));
+    }
+    PointsBlock block = {static_cast<uint32_t>(CoordType::Double), 0, n};
+    WireHeader header = {static_cast<uint32_t>(sizeof block + 2 * n * sizeof(double)),
+                         static_cast<uint32_t>(WireType::Points)};
+    std::string message(reinterpret_cast<const char *>(&header), sizeof header);
+    message.append(reinterpret_cast<const char *>(&block), sizeof block);
+    for (int axis = 0; axis < 2; ++axis) {
+        for (const Point &p: points) {
+            message.append(reinterpret_cast<const char *>(axis == 0 ? &p.x : &p.y), sizeof(double));
+        }
+    }
+    SharedGraph textGraph, binaryGraph;
+    Session textSession(&textGraph), binarySession(&binaryGraph);
+    binarySession.handleLine("Binary");
+
+    auto start = std::chrono::steady_clock::now();
+    receive(textSession, text);
+    auto parsed = std::chrono::steady_clock::now();
+    receive(binarySession, message);
+    auto end = std::chrono::steady_clock::now();
+    printf("n = %zu: text %.1f ms (%.1f MB), binary %.1f ms (%.1f MB), same area: %s\n", n,
+           std::chrono::duration<double, std::milli>(parsed - start).count(), text.size() / 1e6,
+           std::chrono::duration<double, std::milli>(end - parsed).count(), message.size() / 1e6,
+           textGraph.calculator.commandCalculateHull() == binaryGraph.calculator.commandCalculateHull() ? "yes"
+                                                                                                    : "no");
+}
+
+// Throughput of the geometry kernels over n points
+static void benchKernels(size_t n) {
+    std::vector<Point> points = uniformSquare(n, 8);
+    PointStore store(points);
+    std::vector<double> cross(n);
+    double bytes = static_cast<double>(n) * sizeof(Point);
+    double sink = 0;
+    printf("geometry kernels, n = %zu, %s\n", n, cpuHasAvx2() ? "avx2" : "scalar");
+    auto report = [&](const char *name, double ms) {
+        printf("%12s %10.2f ms %8.2f GB/s\n", name, ms, bytes / ms / 1e6);
+    };
+    for (int kernel = 0; kernel < 4; ++kernel) {
+        double best = 1e300;
+        for (int r = 0; r < 5; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            size_t left, right;
+            switch (kernel) {
+                case 0:
+                    orientBatch(store.span(), points[0], points[1], cross.data());
+                    sink += cross[n / 2];
+                    break;
+                case 1:
+                    sink += shoelaceSum(points.data(), n);
+                    break;
+                case 2:
+                    sink += lowestPointIndex(store.span());
+                    break;
+                default:
+                    extremeXIndices(store.span(), left, right);
+                    sink += left + right;
+            }
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        static const char *names[] = {"orientation", "shoelace", "lowest", "extreme x"};
+        report(names[kernel], best);
+    }
+    if (sink == 42) {
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s threads|chan|engines|kernels|coords|churn|dups|files|parse|allocs|wire [n] [max_threads]\n", argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[1], "threads") == 0) {
+        size_t n = argc > 2 ? strtoul(argv[2], nullptr, 10) : 10000000;
+        unsigned hw = std::thread::hardware_concurrency();
+        unsigned maxThreads = argc > 3 ? atoi(argv[3]) : (hw > 1 ? hw : 8);
+        benchThreads(n, maxThreads);
+        return 0;
+    }
+    if (strcmp(argv[1], "chan") == 0) {
+        benchChan(argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+    if (strcmp(argv[1], "engines") == 0) {
+        benchEngines(argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+    if (strcmp(argv[1], "kernels") == 0) {
+        benchKernels(argc > 2 ? strtoul(argv[2], nullptr, 10) : 10000000);
+        return 0;
+    }
+    if (strcmp(argv[1], "coords") == 0) {
+        benchCoords(argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+    if (strcmp(argv[1], "churn") == 0) {
+        benchChurn(argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+    if (strcmp(argv[1], "dups") == 0) {
+        benchDups(argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+    if (strcmp(argv[1], "files") == 0) {
+        benchFiles(argc > 2 ? strtoul(argv[2], nullptr, 10) : 10000000);
+        return 0;
+    }
+    if (strcmp(argv[1], "parse") == 0) {
+        benchParse(argc > 2 ? strtoul(argv[2], nullptr, 10) : 2000000);
+        return 0;
+    }
+    if (strcmp(argv[1], "allocs") == 0) {
+        return benchAllocs(argc > 2 ? strtoul(argv[2], nullptr, 10) : 100000) ? 0 : 1;
+    }
+    if (strcmp(argv[1], "wire") == 0) {
+        benchWire(argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+    fprintf(stderr, "Unknown benchmark: %s\n", argv[1]);
+    return 1;
+}
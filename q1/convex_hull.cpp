@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <cmath>
 #include <string>
+#include <cstring>
+#include "../utils/GraphFile.hpp"
+#include "../utils/PointParser.hpp"
 
 struct Point {
     double x, y;
@@ -80,27 +83,45 @@ double calculateArea(const std::vector<Point>& hull) {
     return std::abs(area) / 2.0;
 }
 
-int main() {
-    int n;
-    std::cin >> n;
-
-    // Consume the newline after the number
-    std::cin.ignore();
-
-    std::vector<Point> points(n);
-
-    for (int i = 0; i < n; ++i) {
-        std::string line;
-        std::getline(std::cin, line);
+// Copies the points of a mapped graph file, converted to double
+template <typename Coord>
+void readGraphFile(const MappedGraphFile& file, std::vector<Point>& points) {
+    const Coord* xs = static_cast<const Coord*>(file.x());
+    const Coord* ys = static_cast<const Coord*>(file.y());
+    points.resize(file.size());
+    for (size_t i = 0; i < file.size(); ++i) {
+        points[i] = Point(static_cast<double>(xs[i]), static_cast<double>(ys[i]));
+    }
+}
 
-        std::size_t commaPos = line.find(',');
-        if (commaPos != std::string::npos) {
-            std::string xStr = line.substr(0, commaPos);
-            std::string yStr = line.substr(commaPos + 1);
-            points[i].x = std::stod(xStr);
-            points[i].y = std::stod(yStr);
+int main(int argc, char* argv[]) {
+    // "-f file" reads a binary graph file (see GraphFile.hpp) instead of the text on stdin
+    if (argc == 3 && strcmp(argv[1], "-f") == 0) {
+        MappedGraphFile file;
+        std::string error;
+        if (!file.open(argv[2], error)) {
+            std::cerr << "Error reading " << argv[2] << ": " << error << std::endl;
+            return 1;
+        }
+        std::vector<Point> points;
+        switch (file.coordType()) {
+            case CoordType::Float: readGraphFile<float>(file, points); break;
+            case CoordType::Int32: readGraphFile<int32_t>(file, points); break;
+            case CoordType::Int64: readGraphFile<int64_t>(file, points); break;
+            default: readGraphFile<double>(file, points);
         }
+        std::vector<Point> hull = grahamScan(points);
+        std::cout << calculateArea(hull) << std::endl;
+        return 0;
     }
+    if (argc != 1) {
+        std::cerr << "Usage: " << argv[0] << " [-f graph file]" << std::endl;
+        return 1;
+    }
+
+    // The count, then one "x,y" point per line, parsed in place
+    std::vector<Point> points;
+    readPointInput<double>(stdin, [&points](double x, double y) { points.emplace_back(x, y); });
 
     std::vector<Point> hull = grahamScan(points);
     double area = calculateArea(hull);
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cmath>
 #include <string>
+#include "../utils/PointParser.hpp"
 
 struct Point {
     double x, y;
@@ -82,26 +83,9 @@ std::deque<Point> grahamScan(std::deque<Point> points) {
 }
 
 int main() {
-    int n;
-    std::cin >> n;
-    
-    // Consume the newline after the number
-    std::cin.ignore();
-
-    std::deque<Point> points(n);
-
-    for (int i = 0; i < n; ++i) {
-        std::string line;
-        std::getline(std::cin, line);
-        
-        std::size_t commaPos = line.find(',');
-        if (commaPos != std::string::npos) {
-            std::string xStr = line.substr(0, commaPos);
-            std::string yStr = line.substr(commaPos + 1);
-            points[i].x = std::stod(xStr);
-            points[i].y = std::stod(yStr);
-        }
-    }
+    // The count, then one "x,y" point per line, parsed in place
+    std::deque<Point> points;
+    readPointInput<double>(stdin, [&points](double x, double y) { points.emplace_back(x, y); });
 
     std::deque<Point> hull = grahamScan(points);
     double area = calculateArea(hull);
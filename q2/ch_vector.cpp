@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cmath>
 #include <string>
+#include "../utils/PointParser.hpp"
 
 struct Point {
     double x, y;
@@ -81,26 +82,9 @@ double calculateArea(const std::vector<Point>& hull) {
 }
 
 int main() {
-    int n;
-    std::cin >> n;
-
-    // Consume the newline after the number
-    std::cin.ignore();
-
-    std::vector<Point> points(n);
-
-    for (int i = 0; i < n; ++i) {
-        std::string line;
-        std::getline(std::cin, line);
-
-        std::size_t commaPos = line.find(',');
-        if (commaPos != std::string::npos) {
-            std::string xStr = line.substr(0, commaPos);
-            std::string yStr = line.substr(commaPos + 1);
-            points[i].x = std::stod(xStr);
-            points[i].y = std::stod(yStr);
-        }
-    }
+    // The count, then one "x,y" point per line, parsed in place
+    std::vector<Point> points;
+    readPointInput<double>(stdin, [&points](double x, double y) { points.emplace_back(x, y); });
 
     std::vector<Point> hull = grahamScan(points);
     double area = calculateArea(hull);
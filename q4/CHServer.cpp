@@ -1,65 +1,34 @@
 #include "../utils/CHServer.hpp"
+#include <unordered_map>
+#include <memory>
 fd_set master; // master file descriptor list
 fd_set read_fds; // temp file descriptor list for select()
 int fdmax; // maximum file descriptor number
 int listener; // listening socket descriptor
+std::unordered_map<int, std::unique_ptr<Session> > sessions; // one per connected client
 
 
 
 struct addrinfo hints, *ai, *p;
 
 void handleRequest(int clientfd) {
-    char buf[256]; // buffer for client data
-    int nbytes;
-    if ((nbytes = recv(clientfd, buf, sizeof buf - 1, 0)) <= 0) {
+    Session &session = *sessions[clientfd];
+    ssize_t nbytes;
+    if ((nbytes = receiveInput(clientfd, session)) <= 0 || !handleInput(clientfd, session)) {
         // got error or connection closed by client
         if (nbytes == 0) {
             // connection closed
             printf("Socket %d hung up\n", clientfd);
         } else {
-            perror("recv");
+            perror(nbytes < 0 ? "recv" : "send");
         }
         close(clientfd); // bye!
         FD_CLR(clientfd, &master); // remove from master set
-    }else {
-        buf[nbytes] = '\0';
-        handleCommand(clientfd, buf);
+        sessions.erase(clientfd);
     }
 
 }
 
-void handleCommand(int clientfd, const std::string &input_command) {
-    std::string command;
-    std::istringstream iss(input_command);
-    std::string response;
-    iss >> command;
-    if (isWaitingForPoints) {
-        if (input_command.find(',') != std::string::npos) {
-            calculator.commandAddPoint(command);
-            isWaitingForPoints--;
-            response = "Point (" + command + ") was added.";
-        } else {
-            response = "Error. Insert point as x, y.";
-        }
-    } else {
-        if (command == "Newgraph") {
-            int n;
-            if (iss >> n) {
-                calculator.commandNewGraph(n);
-                isWaitingForPoints = n;
-                response = "Insert points as x, y. line by line.";
-            } else {
-                response = "Invalid Newgraph command. Usage: Newgraph n";
-                send(clientfd, response.c_str(), response.length(), 0);
-            }
-        } else {
-            response = calculator.processCommand(input_command);
-        }
-    }
-    response += "\n";
-    send(clientfd, response.c_str(), response.length(), 0);
-}
-
 
 void handleAcceptClient(int fd_listener) {
     struct sockaddr_storage remoteaddr; // client address
@@ -71,6 +40,7 @@ void handleAcceptClient(int fd_listener) {
         perror("accept");
     } else {
         FD_SET(newfd, &master); // add to master set
+        sessions[newfd].reset(new Session(&sharedGraph, &graphRegistry));
         if (newfd > fdmax) {
             // keep track of the max
             fdmax = newfd;
@@ -167,14 +137,23 @@ void start() {
 }
 
 void stop() {
-    // Reset the waiting points counter
-    isWaitingForPoints = 0;
+    // Drop the per-client ingest state
+    sessions.clear();
 
     std::cout << "Server shutdown complete" << std::endl;
 }
 
 
 int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "g:")) != -1) {
+        if (opt == 'g') {
+            ConvexHullCalculator::setGraphDirectory(optarg);
+            continue;
+        }
+        fprintf(stderr, "Usage: %s [-g graph file directory]\n", argv[0]);
+        return 1;
+    }
     std::cout << "Starting Convex Hull Server on port " << PORT << std::endl;
 
     // Register signal handlers for graceful shutdown
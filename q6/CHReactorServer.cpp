@@ -1,71 +1,127 @@
 #include "CHReactorServer.hpp"
+#include <fcntl.h>
+#include <sys/eventfd.h>
 /*
- *When client is accepted with unique fd, its corresponding reactorFuncd[fd] is set to handleCommand.
+ *When client is accepted with unique fd, its corresponding reactorFuncd[fd] is set to handleRequest.
  *then, the relevant methods will correspond.
  *
  */
 
-void handleRequest(int clientfd) {
-    char buf[256]; // buffer for client data
-    int nbytes;
-    nbytes = recv(clientfd, buf, sizeof(buf), 0);
-    if (nbytes <= 0) {
-        if (nbytes == 0) {
-            std::cout << "selectserver: socket " << clientfd << " hung up" << std::endl;
-        } else {
-            perror("recv");
+static void closeConnection(int clientfd) {
+    close(clientfd);
+    removeFdFromReactor(current_ctx->reactor, clientfd);
+    current_ctx->connections.erase(clientfd);
+}
+
+// Sends the queued replies of conn until the socket would block. Returns false if the connection
+// failed
+static bool sendQueued(int clientfd, Connection &conn) {
+    std::string &output = conn.session.pendingOutput();
+    while (conn.sent < output.size()) {
+        ssize_t nbytes = send(clientfd, output.data() + conn.sent, output.size() - conn.sent, MSG_NOSIGNAL);
+        if (nbytes == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
         }
-        close(clientfd);
-        removeFdFromReactor(reactor_p, clientfd);
-        return;
+        conn.sent += static_cast<size_t>(nbytes);
+    }
+    if (conn.sent == output.size()) {
+        // keeps its capacity for the next replies
+        output.clear();
+        conn.sent = 0;
+    } else if (conn.sent > output.size() / 2) {
+        // the sent part is dropped once it is the larger one, so each byte moves at most once
+        output.erase(0, conn.sent);
+        conn.sent = 0;
     }
-    buf[nbytes] = '\0';
-    handleCommand(clientfd, buf);
+    return true;
 }
 
-void handleCommand(int clientfd, const std::string &input_command) {
-    std::string command;
-    std::istringstream iss(input_command);
-    std::string response;
-    iss >> command;
-    if (isWaitingForPoints) {
-        if (input_command.find(',') != std::string::npos) {
-            calculator.commandAddPoint(command);
-            isWaitingForPoints--;
-            response = "Point (" + command + ") was added.";
-        } else {
-            response = "Error. Insert point as x, y.";
+void handleWritable(int clientfd) {
+    if (!serviceConnection(clientfd, *current_ctx->connections[clientfd])) {
+        closeConnection(clientfd);
+    }
+}
+
+bool serviceConnection(int clientfd, Connection &conn) {
+    Session &session = conn.session;
+    bool caughtUp;
+    size_t queued;
+    do {
+        caughtUp = session.handleInput(conn.sent + OUTPUT_HIGH_WATER);
+        if (!sendQueued(clientfd, conn)) {
+            perror("send");
+            return false;
         }
-    } else {
-        if (command == "Newgraph") {
-            int n;
-            if (iss >> n) {
-                calculator.commandNewGraph(n);
-                isWaitingForPoints = n;
-                response = "Insert points as x, y. line by line.";
-            } else {
-                response = "Invalid Newgraph command. Usage: Newgraph n";
-                send(clientfd, response.c_str(), response.length(), 0);
-            }
-        } else {
-            response = calculator.processCommand(input_command);
+        queued = session.pendingOutput().size() - conn.sent;
+    } while (!caughtUp && queued <= OUTPUT_LOW_WATER);
+    if (conn.closing && caughtUp && queued == 0) {
+        return false;
+    }
+    // a paused client always has replies queued, so the write watch still sees it hang up
+    bool reading = !conn.closing && caughtUp &&
+                   queued <= (conn.reading ? OUTPUT_HIGH_WATER : OUTPUT_LOW_WATER);
+    if (reading != conn.reading && setFdReading(current_ctx->reactor, clientfd, reading) == 0) {
+        conn.reading = reading;
+    }
+    bool writing = queued > 0;
+    if (writing != conn.writing) {
+        int rv = writing ? addWriteFdToReactor(current_ctx->reactor, clientfd, handleWritable)
+                         : removeWriteFdFromReactor(current_ctx->reactor, clientfd);
+        if (rv == -1) {
+            perror("reactor");
+            return false;
         }
+        conn.writing = writing;
+    }
+    return true;
+}
+
+void handleRequest(int clientfd) {
+    Connection &conn = *current_ctx->connections[clientfd];
+    ssize_t nbytes = receiveInput(clientfd, conn.session);
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (nbytes == -1) {
+        perror("recv");
+        closeConnection(clientfd);
+        return;
+    }
+    if (nbytes == 0) {
+        std::cout << "selectserver: socket " << clientfd << " hung up" << std::endl;
+        // the requests it sent before still get their replies
+        conn.closing = true;
+    }
+    if (!serviceConnection(clientfd, conn)) {
+        closeConnection(clientfd);
     }
-    response += "\n";
-    send(clientfd, response.c_str(), response.length(), 0);
 }
 
 
 void handleAcceptClient(int fd_listener) {
-    int clientfd = accept(fd_listener, nullptr, nullptr);
-    addFdToReactor(reactor_p, clientfd, handleRequest);
+    int clientfd = accept4(fd_listener, nullptr, nullptr, SOCK_NONBLOCK);
+    if (clientfd == -1) {
+        // another reactor sharing the port may have taken it
+        return;
+    }
+    current_ctx->connections[clientfd].reset(new Connection(&current_ctx->graph, &graphRegistry));
+    if (addFdToReactor(current_ctx->reactor, clientfd, handleRequest) == -1) {
+        perror("addFdToReactor");
+        close(clientfd);
+        current_ctx->connections.erase(clientfd);
+    }
 }
 
-void init() {
+int createListener(bool reuseport) {
     int yes = 1; // for setsockopt() SO_REUSEADDR, below
-    int i, j, rv, listener;
+    int rv, listener;
     struct addrinfo hints, *ai, *p;
-    reactor_p = static_cast<reactor_t *>(startReactor());
 
     // get us a socket and bind it
     memset(&hints, 0, sizeof hints);
@@ -85,6 +141,11 @@ void init() {
 
         // lose the pesky "address already in use" error message
         setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
+        // let every reactor bind its own listener; the kernel spreads accepts across them
+        if (reuseport && setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(int)) == -1) {
+            perror("setsockopt SO_REUSEPORT");
+            exit(2);
+        }
 
         if (bind(listener, p->ai_addr, p->ai_addrlen) < 0) {
             close(listener);
@@ -107,43 +168,137 @@ void init() {
         perror("listen");
         exit(3);
     }
-    addFdToReactor(reactor_p, listener, handleAcceptClient);
+    // a connection gone again before accept must not block the reactor
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+    return listener;
+}
+
+void handleWake(int) {
+    breakReactor(current_ctx->reactor);
+}
+
+void handleShutdownSignal(int) {
+    // only async-signal-safe calls here: the reactor threads may be inside their callbacks
+    static const char message[] = "\nShutting down server...\n";
+    stop_requested = 1;
+    if (wake_fd != -1) {
+        uint64_t one = 1;
+        ssize_t written = write(wake_fd, &one, sizeof one);
+        (void) written;
+    }
+    ssize_t written = write(STDOUT_FILENO, message, sizeof message - 1);
+    (void) written;
+}
+
+void init() {
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd == -1) {
+        perror("eventfd");
+        exit(1);
+    }
+    if (reactor_count == 0) {
+        reactor_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 0; i < reactor_count; i++) {
+        std::unique_ptr<ReactorContext> ctx(new ReactorContext());
+        ctx->reactor = static_cast<reactor_t *>(startReactorWithBackend(reactor_backend));
+        if (ctx->reactor == nullptr) {
+            fprintf(stderr, "reactor failure: failed to startReactor\n");
+            exit(1);
+        }
+        ctx->listener = createListener(reactor_count > 1);
+        addFdToReactor(ctx->reactor, ctx->listener, handleAcceptClient);
+        addFdToReactor(ctx->reactor, wake_fd, handleWake);
+        contexts.push_back(std::move(ctx));
+    }
 }
 
 void start() {
     init();
-    if (!run()) {
+    bool ran = run();
+    // every reactor thread has been joined, so nothing uses the contexts any more
+    stop();
+    if (!ran) {
         exit(2);
     }
 }
 
+void runContext(ReactorContext *ctx) {
+    current_ctx = ctx;
+    if (!stop_requested && runReactor(ctx->reactor) == -1) {
+        fprintf(stderr, "reactor failure: failed to runReactor\n");
+    }
+}
+
 int run() {
-    if (!runReactor(reactor_p)) {
-        return 1;
+    // reactors 1..n-1 get their own threads, reactor 0 runs on the calling thread
+    for (size_t i = 1; i < contexts.size(); i++) {
+        contexts[i]->thread = std::thread(runContext, contexts[i].get());
     }
-    fprintf(stderr, "reactor failure: failed to runReactor\n");
-    return 0;
+    current_ctx = contexts[0].get();
+    int rv = stop_requested ? 0 : runReactor(current_ctx->reactor);
+    if (rv == -1) {
+        fprintf(stderr, "reactor failure: failed to runReactor\n");
+        // the other reactors end with this one
+        uint64_t one = 1;
+        ssize_t written = write(wake_fd, &one, sizeof one);
+        (void) written;
+    }
+    for (size_t i = 1; i < contexts.size(); i++) {
+        contexts[i]->thread.join();
+    }
+    return rv == 0;
 }
 
+// Frees the reactors, listeners and graphs once run() has joined every reactor thread
 void stop() {
     std::cout << "CHReactorServer::stop - shutting down server" << std::endl;
-    if (reactor_p != nullptr) {
-        stopReactor(reactor_p);
-        reactor_p = nullptr;
+    for (auto &ctx: contexts) {
+        if (ctx->reactor != nullptr) {
+            stopReactor(ctx->reactor);
+            ctx->reactor = nullptr;
+        }
+        if (ctx->listener != -1) {
+            close(ctx->listener);
+            ctx->listener = -1;
+        }
+        // Drop the per-client ingest state and queued replies
+        ctx->connections.clear();
+    }
+    contexts.clear();
+    if (wake_fd != -1) {
+        close(wake_fd);
+        wake_fd = -1;
     }
-
-    // Reset the waiting points counter
-    isWaitingForPoints = 0;
 
     std::cout << "Server shutdown complete" << std::endl;
 }
 
 int main(int argc, char *argv[]) {
-    std::cout << "Starting Convex Hull Reactor Server on port " << PORT << std::endl;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:n:g:")) != -1) {
+        if (opt == 'b' && parseReactorBackend(optarg, &reactor_backend) == 0) {
+            continue;
+        }
+        if (opt == 'n') {
+            reactor_count = static_cast<unsigned int>(atoi(optarg));
+            continue;
+        }
+        if (opt == 'g') {
+            ConvexHullCalculator::setGraphDirectory(optarg);
+            continue;
+        }
+        fprintf(stderr, "Usage: %s [-b select|epoll] [-n reactors (0 = one per core)] [-g graph file directory]\n",
+                argv[0]);
+        return 1;
+    }
+    std::cout << "Starting Convex Hull Reactor Server on port " << PORT
+            << " (" << (reactor_backend == REACTOR_EPOLL ? "epoll" : "select") << " backend)" << std::endl;
 
     // Register signal handlers for graceful shutdown
-    signal(SIGINT, signalHandler); // Ctrl+C
-    signal(SIGTERM, signalHandler); // Termination request
+    // Only wakes the reactors; start() returns once they have stopped and been freed
+    signal(SIGINT, handleShutdownSignal); // Ctrl+C
+    signal(SIGTERM, handleShutdownSignal); // Termination request
 
     try {
         // Start the server (this will call init() and run())
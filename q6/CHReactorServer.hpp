@@ -2,8 +2,69 @@
 #define CHREACTORSERVER_HPP
 #include "../utils/CHServer.hpp"
 #include "../Reactor/include/Reactor.hpp"
+#include <csignal>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 //struct sockaddr_storage remoteaddr; // client address
 //socklen_t addrlen;
 //char remoteIP[INET6_ADDRSTRLEN];
-reactor_t *reactor_p;
+
+// Replies queued for a client beyond which the reactor stops reading its requests, and the
+// level they must drain to before it reads again
+const size_t OUTPUT_HIGH_WATER = 1 << 20;
+const size_t OUTPUT_LOW_WATER = 1 << 16;
+
+/*
+ * A client of a reactor. Its socket is non-blocking: the replies of its session go out as far
+ * as the socket takes them, and the rest waits in the session's output until the socket is
+ * writable again.
+ */
+struct Connection {
+    Session session;
+    size_t sent = 0;      // bytes of session.pendingOutput() already sent
+    bool reading = true;  // readability watched, false while too many replies are queued
+    bool writing = false; // writability watched, while replies are queued
+    bool closing = false; // the client hung up; closed once its replies are sent
+
+    Connection(SharedGraph *home, GraphRegistry *registry) : session(home, registry) {}
+};
+
+/*
+ * One ReactorContext per reactor thread. A context owns its reactor, its own
+ * SO_REUSEPORT listener, its own graph and the sessions of its clients, so reactors
+ * never share graph state: a session starts on the graph of the reactor the kernel
+ * assigned it to, and may switch to a private graph.
+ */
+struct ReactorContext {
+    reactor_t *reactor = nullptr;
+    int listener = -1;
+    SharedGraph graph;
+    std::unordered_map<int, std::unique_ptr<Connection> > connections;
+    std::thread thread;
+};
+
+std::vector<std::unique_ptr<ReactorContext> > contexts;
+thread_local ReactorContext *current_ctx = nullptr; // context of the reactor running on this thread
+reactor_backend_t reactor_backend = REACTOR_SELECT; // chosen with -b select|epoll
+unsigned int reactor_count = 1; // chosen with -n, 0 means one per core
+
+// eventfd written on SIGINT and SIGTERM. It is left unread, so it stays readable in every
+// reactor and ends all their loops; the reactors are freed only after that
+int wake_fd = -1;
+volatile sig_atomic_t stop_requested = 0; // a signal came, possibly before wake_fd existed
+
+void handleShutdownSignal(int signum);
+
+void handleWake(int fd);
+
+int createListener(bool reuseport);
+
+// Handles the buffered requests of conn while its queued replies stay under OUTPUT_HIGH_WATER,
+// sends what the socket takes and updates what the reactor watches on clientfd. Returns false
+// if the connection failed or is done
+bool serviceConnection(int clientfd, Connection &conn);
+
+void runContext(ReactorContext *ctx);
 #endif //CHREACTORSERVER_HPP
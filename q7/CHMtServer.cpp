@@ -2,7 +2,7 @@
 
 int listener;
 int isRunning = 0;
-std::mutex mtx;
+thread_local Session *session = nullptr; // session of the client served by this thread
 
 void init() {
     int yes = 1; // for setsockopt() SO_REUSEADDR, below
@@ -71,59 +71,25 @@ void start() {
 }
 
 void handleRequest(int clientfd) {
-    char buf[256]; // buffer for client data
-    int nbytes;
+    ssize_t nbytes;
+    Session client_session(&sharedGraph, &graphRegistry);
+    session = &client_session;
     while (isRunning) {
-        if ((nbytes = recv(clientfd, buf, sizeof buf - 1, 0)) <= 0) {
+        if ((nbytes = receiveInput(clientfd, *session)) <= 0 || !handleInput(clientfd, *session)) {
             // got error or connection closed by client
             if (nbytes == 0) {
                 // connection closed
                 printf("Socket %d hung up\n", clientfd);
             } else {
-                perror("recv");
+                perror(nbytes < 0 ? "recv" : "send");
             }
             break;
         }
-        buf[nbytes] = '\0';
-        mtx.lock();
-        handleCommand(clientfd, buf);
-        mtx.unlock();
     }
+    session = nullptr;
     close(clientfd); // bye!
 }
 
-void handleCommand(int clientfd, const std::string &input_command) {
-    std::string command;
-    std::istringstream iss(input_command);
-    std::string response;
-    iss >> command;
-    if (isWaitingForPoints) {
-        if (input_command.find(',') != std::string::npos) {
-            calculator.commandAddPoint(command);
-            isWaitingForPoints--;
-            response = "Point (" + command + ") was added.";
-        } else {
-            response = "Error. Insert point as x, y.";
-        }
-    } else {
-        if (command == "Newgraph") {
-            int n;
-            if (iss >> n) {
-                calculator.commandNewGraph(n);
-                isWaitingForPoints = n;
-                response = "Insert points as x, y. line by line.";
-            } else {
-                response = "Invalid Newgraph command. Usage: Newgraph n";
-                send(clientfd, response.c_str(), response.length(), 0);
-            }
-        } else {
-            response = calculator.processCommand(input_command);
-        }
-    }
-    response += "\n";
-    send(clientfd, response.c_str(), response.length(), 0);
-}
-
 
 void handleAcceptClient(int fd_listener) {
     std::cout << "Accepted connection THREAD, listening on socket " << fd_listener << std::endl;
@@ -141,7 +107,16 @@ void handleAcceptClient(int fd_listener) {
     }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "g:")) != -1) {
+        if (opt == 'g') {
+            ConvexHullCalculator::setGraphDirectory(optarg);
+            continue;
+        }
+        fprintf(stderr, "Usage: %s [-g graph file directory]\n", argv[0]);
+        return 1;
+    }
     std::cout << "Starting Convex Hull Multithreading Server on port " << PORT << std::endl;
 
     // Register signal handlers for graceful shutdown
@@ -1,9 +1,16 @@
 #include "CHProactorServer.hpp"
 #include "../Proactor/include/Proactor.hpp"
+#include "../Proactor/include/AsyncProactor.hpp"
 int listener;
 int isRunning = 0;
-
-pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+int async_mode = 1; // -m async (completion-based proactor loops) or -m pool (worker pool)
+void *pool = nullptr; // workers that serve client requests
+int pool_workers = 8; // chosen with -w
+int pool_queue_depth = 1024; // chosen with -q
+int loop_count = 2; // completion loops in async mode, chosen with -t
+int force_epoll = 0; // -b epoll skips io_uring
+std::vector<void *> loops; // one async proactor per loop thread
+std::vector<pthread_t> loop_threads;
 
 void init() {
     int yes = 1; // for setsockopt() SO_REUSEADDR, below
@@ -46,7 +53,7 @@ void init() {
     freeaddrinfo(ai); // all done with this
 
     // listen
-    if (listen(listener, 10) == -1) {
+    if (listen(listener, SOMAXCONN) == -1) {
         perror("listen");
         exit(3);
     }
@@ -54,6 +61,14 @@ void init() {
 
 int run() {
     isRunning = 1;
+    if (async_mode) {
+        return runAsyncLoops();
+    }
+    pool = startProactorPool(pool_workers, pool_queue_depth);
+    if (pool == nullptr) {
+        fprintf(stderr, "proactor failure: failed to startProactorPool\n");
+        return 0;
+    }
     pthread_t accept_thread = startProactor(&listener, proactorFunc(handleAcceptClient));
     pthread_detach(accept_thread);
     std::cout << "accepting-thread, Address: " << &accept_thread << " started.\n" << std::endl;
@@ -62,69 +77,199 @@ int run() {
 
 void stop() {
     isRunning = 0;
+    for (void *loop: loops) {
+        stopAsyncProactor(loop);
+    }
     close(listener);
+    if (pool != nullptr) {
+        printMetrics();
+        stopProactorPool(pool);
+        pool = nullptr;
+    }
     std::cout << "Server stopped.\n";
 }
 
+void printMetrics() {
+    proactor_metrics_t m;
+    if (getProactorMetrics(pool, &m) == -1) {
+        return;
+    }
+    printf("proactor: %d workers, %llu requests, queue wait avg %.1fus max %.1fus, "
+           "utilization %.1f%%, %d queued, %llu full-queue waits\n",
+           m.workers, (unsigned long long) m.tasks_completed, m.avg_queue_wait_us, m.max_queue_wait_us,
+           m.utilization * 100.0, m.queued, (unsigned long long) m.queue_full_waits);
+}
+
 void start() {
     init();
     run();
 }
 
-void handleRequest(void* arg) {
-    int clientfd = *(int*)arg;
-    char buf[256]; // buffer for client data
-    int nbytes;
-    while (isRunning) {
-        if ((nbytes = recv(clientfd, buf, sizeof buf - 1, 0)) <= 0) {
-            // got error or connection closed by client
-            if (nbytes == 0) {
-                // connection closed
-                printf("Socket %d hung up\n", clientfd);
-            } else {
-                perror("recv");
-            }
-            break;
+int handleRequest(int clientfd, void* arg) {
+    Session &session = *static_cast<Session *>(arg);
+    ssize_t nbytes;
+    if (!isRunning) {
+        return PROACTOR_CLOSE;
+    }
+    if ((nbytes = receiveInput(clientfd, session)) <= 0 || !handleInput(clientfd, session)) {
+        // got error or connection closed by client
+        if (nbytes == 0) {
+            // connection closed
+            printf("Socket %d hung up\n", clientfd);
+        } else {
+            perror(nbytes < 0 ? "recv" : "send");
         }
-        buf[nbytes] = '\0';
-        pthread_mutex_lock(&mtx);
-        handleCommand(clientfd, buf);
-        pthread_mutex_unlock(&mtx);
+        return PROACTOR_CLOSE;
     }
-    close(clientfd); // bye!
+    return PROACTOR_REARM;
+}
+
+void handleRequestDone(int clientfd, int result, void* arg) {
+    if (result == PROACTOR_CLOSE) {
+        close(clientfd); // bye!
+        delete static_cast<Session *>(arg);
+    }
+}
+
+int runAsyncLoops() {
+    for (int i = 0; i < loop_count; i++) {
+        void *loop = force_epoll
+                         ? startAsyncProactorWithBackend(ASYNC_BACKEND_EPOLL, 256)
+                         : startAsyncProactor(256);
+        if (loop == nullptr || asyncAccept(loop, listener, onAccept, nullptr) == -1) {
+            perror("proactor failure: failed to start completion loop");
+            return 0;
+        }
+        loops.push_back(loop);
+    }
+    std::cout << loop_count << " completion loops on "
+            << (asyncProactorBackend(loops[0]) == ASYNC_BACKEND_URING ? "io_uring" : "epoll") << std::endl;
+    for (void *loop: loops) {
+        pthread_t tid;
+        if (pthread_create(&tid, nullptr, runLoop, loop) != 0) {
+            perror("pthread_create");
+            return 0;
+        }
+        pthread_detach(tid);
+        loop_threads.push_back(tid);
+    }
+    return 1;
+}
+
+void *runLoop(void *loop) {
+    if (runAsyncProactor(loop) == -1) {
+        fprintf(stderr, "proactor failure: completion loop stopped\n");
+    }
+    return nullptr;
+}
+
+void closeConnection(Connection *conn) {
+    close(conn->fd); // bye!
+    delete conn;
+}
 
+void onAccept(void *loop, async_op_t /*op*/, int fd_listener, int result, void * /*arg*/) {
+    // keep exactly one accept outstanding per loop
+    if (isRunning) {
+        asyncAccept(loop, fd_listener, onAccept, nullptr);
+    }
+    if (result < 0) {
+        fprintf(stderr, "accept: %s\n", strerror(-result));
+        return;
+    }
+    Connection *conn = new Connection(result);
+    if (receiveAsync(loop, conn) == -1) {
+        perror("asyncRecv");
+        closeConnection(conn);
+    }
 }
 
-void handleCommand(int clientfd, const std::string &input_command) {
-    std::string command;
-    std::istringstream iss(input_command);
-    std::string response;
-    iss >> command;
-    if (isWaitingForPoints) {
-        if (input_command.find(',') != std::string::npos) {
-            calculator.commandAddPoint(command);
-            isWaitingForPoints--;
-            response = "Point (" + command + ") was added.";
+void onRecv(void *loop, async_op_t /*op*/, int clientfd, int result, void *arg) {
+    Connection *conn = static_cast<Connection *>(arg);
+    if (result <= 0) {
+        // got error or connection closed by client
+        if (result == 0) {
+            printf("Socket %d hung up\n", clientfd);
         } else {
-            response = "Error. Insert point as x, y.";
+            fprintf(stderr, "recv: %s\n", strerror(-result));
+        }
+        closeConnection(conn);
+        return;
+    }
+    conn->session.pendingInput().commit(static_cast<size_t>(result));
+    conn->session.handleInput();
+    std::string &reply = conn->session.pendingOutput();
+    // nothing to answer until a line is complete
+    int submitted = reply.empty() ? receiveAsync(loop, conn)
+                                  : asyncSend(loop, clientfd, reply.data(), reply.size(), onSend, conn);
+    if (submitted == -1) {
+        perror(reply.empty() ? "asyncRecv" : "asyncSend");
+        closeConnection(conn);
+    }
+}
+
+void onSend(void *loop, async_op_t /*op*/, int clientfd, int result, void *arg) {
+    Connection *conn = static_cast<Connection *>(arg);
+    if (result < 0) {
+        fprintf(stderr, "send: %s\n", strerror(-result));
+        closeConnection(conn);
+        return;
+    }
+    // the rest of the replies after a short send, else the next commands
+    std::string &reply = conn->session.pendingOutput();
+    conn->sent += static_cast<size_t>(result);
+    if (conn->sent < reply.size()) {
+        if (asyncSend(loop, clientfd, reply.data() + conn->sent, reply.size() - conn->sent, onSend, conn) == -1) {
+            perror("asyncSend");
+            closeConnection(conn);
         }
-    } else {
-        if (command == "Newgraph") {
-            int n;
-            if (iss >> n) {
-                calculator.commandNewGraph(n);
-                isWaitingForPoints = n;
-                response = "Insert points as x, y. line by line.";
-            } else {
-                response = "Invalid Newgraph command. Usage: Newgraph n";
-                send(clientfd, response.c_str(), response.length(), 0);
+        return;
+    }
+    reply.clear();
+    conn->sent = 0;
+    if (receiveAsync(loop, conn) == -1) {
+        perror("asyncRecv");
+        closeConnection(conn);
+    }
+}
+
+int receiveAsync(void *loop, Connection *conn) {
+    LineBuffer &input = conn->session.pendingInput();
+    char *room = input.prepare(READ_SIZE);
+    return asyncRecv(loop, conn->fd, room, input.space(), onRecv, conn);
+}
+
+ssize_t receiveInput(int clientfd, Session &session) {
+    LineBuffer &input = session.pendingInput();
+    char *room = input.prepare(READ_SIZE);
+    ssize_t nbytes = recv(clientfd, room, input.space(), 0);
+    if (nbytes > 0) {
+        input.commit(static_cast<size_t>(nbytes));
+    }
+    return nbytes;
+}
+
+bool handleInput(int clientfd, Session &session) {
+    session.handleInput();
+    std::string &reply = session.pendingOutput();
+    bool sent = sendAll(clientfd, reply.data(), reply.size());
+    reply.clear();
+    return sent;
+}
+
+bool sendAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
             }
-        } else {
-            response = calculator.processCommand(input_command);
+            return false;
         }
+        data += sent;
+        length -= static_cast<size_t>(sent);
     }
-    response += "\n";
-    send(clientfd, response.c_str(), response.length(), 0);
+    return true;
 }
 
 
@@ -138,15 +283,40 @@ void handleAcceptClient(void* arg) {
             perror("accept");
             continue;
         }
-        pthread_t client_thread = startProactor(&newfd, proactorFunc(handleRequest));
-        pthread_detach(client_thread);
-        std::cout << "client-thread, address: " << &client_thread << " started with socket" << newfd << "\n" <<
-                std::endl;
+        Session *session = new Session(&sharedGraph, &graphRegistry);
+        if (addFdToProactor(pool, newfd, handleRequest, handleRequestDone, session) == -1) {
+            perror("addFdToProactor");
+            delete session;
+            close(newfd);
+            continue;
+        }
+        std::cout << "client on socket " << newfd << " handed to the proactor pool\n" << std::endl;
     }
 }
 
-int main() {
-    std::cout << "Starting Convex Hull Proactor Server on port " << PORT << std::endl;
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "m:t:b:w:q:g:")) != -1) {
+        if (opt == 'm' && (strcmp(optarg, "async") == 0 || strcmp(optarg, "pool") == 0)) {
+            async_mode = strcmp(optarg, "async") == 0;
+        } else if (opt == 't') {
+            loop_count = std::max(1, atoi(optarg));
+        } else if (opt == 'b' && (strcmp(optarg, "uring") == 0 || strcmp(optarg, "epoll") == 0)) {
+            force_epoll = strcmp(optarg, "epoll") == 0;
+        } else if (opt == 'w') {
+            pool_workers = atoi(optarg);
+        } else if (opt == 'q') {
+            pool_queue_depth = atoi(optarg);
+        } else if (opt == 'g') {
+            ConvexHullCalculator::setGraphDirectory(optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-m async|pool] [-t loops] [-b uring|epoll] [-w workers] [-q queue depth] "
+                    "[-g graph file directory]\n", argv[0]);
+            return 1;
+        }
+    }
+    std::cout << "Starting Convex Hull Proactor Server on port " << PORT
+            << " (" << (async_mode ? "async" : "pool") << " mode)" << std::endl;
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
     try {
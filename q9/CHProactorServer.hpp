@@ -16,20 +16,61 @@
 #include <string>
 #include <sstream>
 #include <csignal>
+#include <vector>
 #include "../utils/ConvexHullCalculator.hpp"
-ConvexHullCalculator calculator;
-int isWaitingForPoints = 0;
+#include "../utils/Session.hpp"
+#include "../utils/GraphRegistry.hpp"
+#include "../Proactor/include/AsyncProactor.hpp"
+SharedGraph sharedGraph; // graph sessions bind to unless they go private or use a named graph
+GraphRegistry graphRegistry; // named graphs, shared by every session
 struct sockaddr_storage remoteaddr; // client address
 socklen_t addrlen;
 
 
 char remoteIP[INET6_ADDRSTRLEN];
 
+const size_t READ_SIZE = 16384; // free space each recv gets in the session's input buffer
+
+// per-client state of the completion loops: the session, which receives into its input buffer
+// and holds the replies being sent, and how much of them was sent
+struct Connection {
+    int fd;
+    Session session;
+    size_t sent = 0;
+
+    explicit Connection(int fd) : fd(fd), session(&sharedGraph, &graphRegistry) {}
+};
+
 void *get_in_addr(struct sockaddr *sa);
 
-void handleRequest(void* arg);
+int handleRequest(int clientfd, void* arg);
+
+void handleRequestDone(int clientfd, int result, void* arg);
+
+// Receives what the client sent into the input buffer of its session. Returns what recv returned
+ssize_t receiveInput(int clientfd, Session &session);
+
+// Handles every complete command the client sent and sends all their replies in one send.
+// Returns false if the connection failed
+bool handleInput(int clientfd, Session &session);
+
+// Sends all length bytes of data, retrying short sends. Returns false if the connection failed
+bool sendAll(int fd, const char *data, size_t length);
 
-void handleCommand(int clientfd, const std::string &input_command);
+// Submits a recv into the input buffer of the connection's session
+int receiveAsync(void *loop, Connection *conn);
+
+int runAsyncLoops();
+
+void *runLoop(void *loop);
+
+void closeConnection(Connection *conn);
+
+void onAccept(void *loop, async_op_t op, int fd_listener, int result, void *arg);
+
+void onRecv(void *loop, async_op_t op, int clientfd, int result, void *arg);
+
+void onSend(void *loop, async_op_t op, int clientfd, int result, void *arg);
 
 void handleAcceptClient(void* arg);
 
@@ -41,6 +82,8 @@ void stop();
 
 void start();
 
+void printMetrics();
+
 void *get_in_addr(struct sockaddr *sa) {
     if (sa->sa_family == AF_INET) {
         return &(((struct sockaddr_in *) sa)->sin_addr);
@@ -6,6 +6,31 @@
 #define CHSERVER_HPP
 #include "Server.hpp"
 #include "ConvexHullCalculator.hpp"
-ConvexHullCalculator calculator;
-int isWaitingForPoints = 0;
+#include "Session.hpp"
+#include "GraphRegistry.hpp"
+SharedGraph sharedGraph; // graph sessions bind to unless they go private or use a named graph
+GraphRegistry graphRegistry; // named graphs, shared by every session
+
+const size_t READ_SIZE = 16384; // free space each recv gets in the session's input buffer
+
+// Receives what the client sent into the input buffer of its session. Returns what recv returned
+ssize_t receiveInput(int clientfd, Session &session) {
+    LineBuffer &input = session.pendingInput();
+    char *room = input.prepare(READ_SIZE);
+    ssize_t nbytes = recv(clientfd, room, input.space(), 0);
+    if (nbytes > 0) {
+        input.commit(static_cast<size_t>(nbytes));
+    }
+    return nbytes;
+}
+
+// Handles every complete command the client sent and sends all their replies in one send.
+// Returns false if the connection failed
+bool handleInput(int clientfd, Session &session) {
+    session.handleInput();
+    std::string &reply = session.pendingOutput();
+    bool sent = sendAll(clientfd, reply.data(), reply.size());
+    reply.clear();
+    return sent;
+}
 #endif //CHSERVER_HPP
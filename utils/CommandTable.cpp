@@ -0,0 +1,99 @@
+#include "CommandTable.hpp"
+
+namespace {
+    // In Command order, from the first after Unknown
+    constexpr std::string_view COMMAND_NAMES[] = {
+        "Newgraph", "CH", "Newpoint", "Removepoint", "Loadgraph", "Savegraph", "Removerect", "Countrect",
+        "Removecircle", "Countcircle", "Version", "Engine", "Stats", "Prefilter", "Dedup", "Threads", "help",
+        "exit", "Use", "Private", "Shared", "Binary"};
+
+    constexpr size_t COMMAND_COUNT = sizeof COMMAND_NAMES / sizeof COMMAND_NAMES[0];
+
+    static_assert(COMMAND_COUNT == static_cast<size_t>(Command::Binary), "a name for every command");
+
+    // 2^SLOT_BITS slots for the names, about three per name
+    constexpr unsigned SLOT_BITS = 6;
+
+    // FNV-1a of name from seed, its top SLOT_BITS bits
+    constexpr unsigned slotOf(std::string_view name, uint32_t seed) {
+        uint32_t hash = seed;
+        for (char c: name) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return hash >> (32 - SLOT_BITS);
+    }
+
+    struct CommandSlots {
+        uint32_t seed = 0;
+        uint8_t slots[1 << SLOT_BITS] = {}; // Command in each slot, Unknown if empty
+    };
+
+    // Tries seeds from the FNV offset basis up until every name has a slot of its own
+    constexpr CommandSlots buildSlots() {
+        for (uint32_t seed = 2166136261u;; ++seed) {
+            CommandSlots table;
+            table.seed = seed;
+            bool collided = false;
+            for (size_t i = 0; i < COMMAND_COUNT && !collided; ++i) {
+                uint8_t &slot = table.slots[slotOf(COMMAND_NAMES[i], seed)];
+                collided = slot != 0;
+                slot = static_cast<uint8_t>(i + 1);
+            }
+            if (!collided) {
+                return table;
+            }
+        }
+    }
+
+    constexpr CommandSlots COMMAND_SLOTS = buildSlots();
+
+    bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+}
+
+Command lookupCommand(std::string_view name) {
+    uint8_t slot = COMMAND_SLOTS.slots[slotOf(name, COMMAND_SLOTS.seed)];
+    if (slot == 0 || COMMAND_NAMES[slot - 1] != name) {
+        return Command::Unknown;
+    }
+    return static_cast<Command>(slot);
+}
+
+std::string_view commandName(Command command) {
+    if (command == Command::Unknown) {
+        return std::string_view();
+    }
+    return COMMAND_NAMES[static_cast<size_t>(command) - 1];
+}
+
+std::string_view nextToken(std::string_view &text) {
+    size_t start = 0;
+    while (start < text.size() && isBlank(text[start])) {
+        ++start;
+    }
+    size_t end = start;
+    while (end < text.size() && !isBlank(text[end])) {
+        ++end;
+    }
+    std::string_view token = text.substr(start, end - start);
+    text.remove_prefix(end);
+    return token;
+}
+
+std::string_view trimBlanks(std::string_view text) {
+    while (!text.empty() && isBlank(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && isBlank(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+void appendFixed(std::string &out, double value) {
+    // the longest fixed double: 309 integer digits, a sign, a point and six decimals
+    char digits[320];
+    std::to_chars_result written = std::to_chars(digits, digits + sizeof digits, value, std::chars_format::fixed, 6);
+    out.append(digits, static_cast<size_t>(written.ptr - digits));
+}
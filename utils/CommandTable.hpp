@@ -0,0 +1,65 @@
+//
+// Command names of the text protocol, looked up through a perfect hash built at compile time,
+// and the allocation-free helpers the dispatchers tokenize and format replies with.
+//
+
+#ifndef COMMANDTABLE_HPP
+#define COMMANDTABLE_HPP
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Every command of the protocol, the session ones (Use, Private, Shared, Binary) included
+enum class Command : uint8_t {
+    Unknown,
+    Newgraph,
+    CH,
+    Newpoint,
+    Removepoint,
+    Loadgraph,
+    Savegraph,
+    Removerect,
+    Countrect,
+    Removecircle,
+    Countcircle,
+    Version,
+    Engine,
+    Stats,
+    Prefilter,
+    Dedup,
+    Threads,
+    Help,
+    Exit,
+    Use,
+    Private,
+    Shared,
+    Binary
+};
+
+// Command named name, case-sensitive; Unknown for anything else. One hash and one comparison
+Command lookupCommand(std::string_view name);
+
+// Name of command as clients type it, "" for Unknown
+std::string_view commandName(Command command);
+
+// Splits the first token off text: skips blanks, returns the token up to the next blank and
+// leaves text at that blank. Empty when text holds only blanks
+std::string_view nextToken(std::string_view& text);
+
+// text without its leading and trailing blanks
+std::string_view trimBlanks(std::string_view text);
+
+// Appends value in decimal
+template <typename Integer>
+void appendInteger(std::string& out, Integer value) {
+    char digits[24];
+    std::to_chars_result written = std::to_chars(digits, digits + sizeof digits, value);
+    out.append(digits, static_cast<size_t>(written.ptr - digits));
+}
+
+// Appends value with six decimals, as std::to_string formats a double
+void appendFixed(std::string& out, double value);
+
+#endif //COMMANDTABLE_HPP
@@ -1,207 +1,771 @@
 #include "ConvexHullCalculator.hpp"
+#include <functional>
+#include <thread>
+#include <type_traits>
 
-double ConvexHullCalculator::crossProduct(const Point &p1, const Point &p2, const Point &p3) {
-    return (p2.x - p1.x) * (p3.y - p1.y) - (p2.y - p1.y) * (p3.x - p1.x);
-}
+namespace {
+    // v as a coordinate, clamped to the accepted range for the integer types
+    template <typename Coord>
+    Coord toCoord(typename CoordTraits<Coord>::Diff v) {
+        if constexpr (std::is_integral<Coord>::value) {
+            return static_cast<Coord>(std::max<typename CoordTraits<Coord>::Diff>(
+                -CoordTraits<Coord>::limit, std::min<typename CoordTraits<Coord>::Diff>(v, CoordTraits<Coord>::limit)));
+        } else {
+            return static_cast<Coord>(v);
+        }
+    }
 
-double ConvexHullCalculator::distanceSquared(const Point &p1, const Point &p2) {
-    return (p2.x - p1.x) * (p2.x - p1.x) + (p2.y - p1.y) * (p2.y - p1.y);
-}
+    // Appends to out the positions in store of the points in region, whose arguments args are in
+    // the coordinate type of the store. square holds the candidates of a circle. Returns false if
+    // the arguments do not parse
+    template <typename Store>
+    bool findInRegion(Store &store, Region region, std::string_view args, std::vector<PointIndex> &out,
+                      std::vector<PointIndex> &square) {
+        typedef typename Store::value_type Coord;
+        typedef typename CoordTraits<Coord>::Diff Diff;
+        typedef typename CoordTraits<Coord>::Wide Wide;
+        Coord values[4];
+        if (region == Region::Rect) {
+            if (parseCoordinateList<Coord>(args, values, 4) != ParseStatus::Ok) {
+                return false;
+            }
+            store.findInRect(std::min(values[0], values[2]), std::min(values[1], values[3]),
+                             std::max(values[0], values[2]), std::max(values[1], values[3]), out);
+            return true;
+        }
+        if (parseCoordinateList<Coord>(args, values, 3) != ParseStatus::Ok || !(values[2] >= 0)) {
+            return false;
+        }
+        // the bounding square from the grid, then the exact test; Wide holds the squared distances
+        Diff cx = values[0], cy = values[1], r = values[2];
+        square.clear();
+        store.findInRect(toCoord<Coord>(cx - r), toCoord<Coord>(cy - r), toCoord<Coord>(cx + r),
+                         toCoord<Coord>(cy + r), square);
+        BasicPointSpan<Coord> span = store.span();
+        for (PointIndex i: square) {
+            Diff dx = static_cast<Diff>(span.x[i]) - cx, dy = static_cast<Diff>(span.y[i]) - cy;
+            if (static_cast<Wide>(dx) * dx + static_cast<Wide>(dy) * dy <= static_cast<Wide>(r) * r) {
+                out.push_back(i);
+            }
+        }
+        return true;
+    }
 
-Point ConvexHullCalculator::parsePoint(const std::string &str) {
-    std::size_t commaPos = str.find(',');
-    if (commaPos != std::string::npos) {
-        std::string xStr = str.substr(0, commaPos);
-        std::string yStr = str.substr(commaPos + 1);
-        try {
-            double x = std::stod(xStr);
-            double y = std::stod(yStr);
-            return Point(x, y);
-        } catch (const std::exception &e) {
-            std::cerr << "Error parsing point: " << str << std::endl;
+    // Points at the given positions of span, in that order
+    template <typename Coord>
+    std::vector<Point> gather(const BasicPointSpan<Coord> &span, const std::vector<PointIndex> &indices) {
+        std::vector<Point> out;
+        out.reserve(indices.size());
+        for (PointIndex i: indices) {
+            out.push_back(span.at(i));
         }
+        return out;
     }
-    return Point(0, 0); // Default return if parsing fails
 }
 
 std::vector<Point> ConvexHullCalculator::grahamScan(std::vector<Point> points) {
-    int n = points.size();
-    if (n <= 2) return points; // Handle edge cases
+    PointStore store(points);
+    return gather(store.span(), grahamScanIndices(store.span()));
+}
+
+std::vector<Point> ConvexHullCalculator::monotoneChain(std::vector<Point> points) {
+    PointStore store(points);
+    return gather(store.span(), monotoneChainIndices(store.span()));
+}
+
+std::vector<Point> ConvexHullCalculator::chanHull(std::vector<Point> points) {
+    PointStore store(points);
+    return gather(store.span(), chanIndices(store.span()));
+}
+
+std::vector<Point> ConvexHullCalculator::quickhull(std::vector<Point> points) {
+    PointStore store(points);
+    return gather(store.span(), quickhullIndices(store.span()));
+}
 
-    // Find the lowest point (and if tied, the leftmost)
-    int lowestIdx = 0;
-    for (int i = 1; i < n; ++i) {
-        if (points[i].y < points[lowestIdx].y ||
-            (points[i].y == points[lowestIdx].y && points[i].x < points[lowestIdx].x)) {
-            lowestIdx = i;
+template <typename Coord>
+HullEngine ConvexHullCalculator::selectEngine(const BasicPointSpan<Coord> &points, HullStats &rangeStats) {
+    size_t n = points.size;
+    rangeStats.sortedInput = true;
+    for (size_t i = 1; i < n && rangeStats.sortedInput; ++i) {
+        rangeStats.sortedInput = points.x[i - 1] < points.x[i] ||
+                                 (points.x[i - 1] == points.x[i] && points.y[i - 1] <= points.y[i]);
+    }
+    if (n <= 64) {
+        // too few points for anything to beat a plain sort
+        return HullEngine::MonotoneChain;
+    }
+
+    // hull share of an evenly strided sample; a share that is already small in the sample only
+    // gets smaller in the full input
+    const size_t sampleSize = 256;
+    BasicPointStore<Coord> sample;
+    sample.reserve(sampleSize);
+    size_t stride = std::max<size_t>(1, n / sampleSize);
+    for (size_t i = 0; i < n && sample.size() < sampleSize; i += stride) {
+        sample.push_back(points.x[i], points.y[i]);
+    }
+    double fraction = static_cast<double>(monotoneChainIndices(sample.span()).size()) / sample.size();
+    rangeStats.sampledHullFraction = fraction;
+
+    if (fraction < 0.5) {
+        // mostly interior points: Quickhull discards them in its first partitions. It measured
+        // faster than Chan even for 16 hull vertices in 1M points, so Chan is never picked
+        return HullEngine::Quickhull;
+    }
+    // most points are hull vertices, the worst case of Quickhull and Chan; sorted input also
+    // skips the sort here
+    return HullEngine::MonotoneChain;
+}
+
+template <typename Coord>
+std::vector<PointIndex> ConvexHullCalculator::hullOfRange(const BasicPointSpan<Coord> &range, HullStats &rangeStats) {
+    BasicPointSpan<Coord> candidates = range;
+    BasicPointStore<Coord> survivors;
+    std::vector<PointIndex> kept;
+    bool compacted = false;
+    rangeStats.culledPoints = 0;
+    if (prefilter) {
+        rangeStats.culledPoints = aklToussaintFilter(range, kept);
+        // the engines give the same hull with or without the culled points, so the survivors
+        // are only copied out when that saves the engine a good share of its input
+        if (rangeStats.culledPoints >= range.size / 4) {
+            survivors.reserve(kept.size());
+            for (PointIndex i: kept) {
+                survivors.push_back(range.x[i], range.y[i]);
+            }
+            candidates = survivors.span();
+            compacted = true;
         }
     }
+    HullEngine selected = engine;
+    if (selected == HullEngine::Auto) {
+        selected = selectEngine(candidates, rangeStats);
+    }
+    rangeStats.engine = selected;
+    std::vector<PointIndex> hull;
+    switch (selected) {
+        case HullEngine::MonotoneChain:
+            hull = monotoneChainIndices(candidates, rangeStats.sortedInput);
+            break;
+        case HullEngine::Chan:
+            hull = chanIndices(candidates);
+            break;
+        case HullEngine::Quickhull:
+            hull = quickhullIndices(candidates);
+            break;
+        default:
+            hull = grahamScanIndices(candidates);
+    }
+    if (compacted) {
+        for (PointIndex &i: hull) {
+            i = kept[i];
+        }
+    }
+    return hull;
+}
 
-    // Make the lowest point the first point
-    std::swap(points[0], points[lowestIdx]);
+template <typename Coord>
+std::vector<Point> ConvexHullCalculator::parallelHull(const BasicPointSpan<Coord> &points, unsigned threads) {
+    std::vector<std::vector<PointIndex> > partial(threads);
+    std::vector<HullStats> chunkStats(threads);
+    std::vector<std::thread> workers;
+    size_t chunk = (points.size + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; ++t) {
+        BasicPointSpan<Coord> range = points.sub(std::min(points.size, t * chunk),
+                                                 std::min(points.size, (t + 1) * chunk));
+        if (t + 1 == threads) {
+            // the calling thread takes the last chunk instead of idling in join
+            partial[t] = hullOfRange(range, chunkStats[t]);
+        } else {
+            workers.emplace_back([this, range, &partial, &chunkStats, t] {
+                partial[t] = hullOfRange(range, chunkStats[t]);
+            });
+        }
+    }
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
 
-    // Sort points by polar angle with respect to the lowest point
-    Point pivot = points[0];
-    std::sort(points.begin() + 1, points.end(), [&pivot, this](const Point &p1, const Point &p2) {
-        double cross = crossProduct(pivot, p1, p2);
-        if (fabs(cross) < 1e-9) {
-            // If collinear, sort by distance from pivot
-            return distanceSquared(pivot, p1) < distanceSquared(pivot, p2);
+    // the hull of the partial hulls is the hull of all points
+    BasicPointStore<Coord> merged;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t offset = std::min(points.size, t * chunk);
+        for (PointIndex i: partial[t]) {
+            merged.push_back(points.x[offset + i], points.y[offset + i]);
         }
-        return cross > 0; // Counter-clockwise orientation
-    });
+        stats.culledPoints += chunkStats[t].culledPoints;
+    }
+    stats.engine = chunkStats[0].engine;
+    stats.sortedInput = chunkStats[0].sortedInput;
+    stats.sampledHullFraction = chunkStats[0].sampledHullFraction;
+    return gather(merged.span(), monotoneChainIndices(merged.span()));
+}
+
+template <typename Coord>
+std::vector<Point> ConvexHullCalculator::computeHull(const BasicPointSpan<Coord> &points) {
+    stats = HullStats();
+    stats.inputPoints = points.size;
+    unsigned threads = parallelThreads ? parallelThreads : std::thread::hardware_concurrency();
+    if (threads > 1 && points.size >= parallelThreshold) {
+        stats.threads = threads;
+        return parallelHull(points, threads);
+    }
+    return gather(points, hullOfRange(points, stats));
+}
+
+template std::vector<Point> ConvexHullCalculator::computeHull(const BasicPointSpan<double> &);
+template std::vector<Point> ConvexHullCalculator::computeHull(const BasicPointSpan<float> &);
+template std::vector<Point> ConvexHullCalculator::computeHull(const BasicPointSpan<int32_t> &);
+template std::vector<Point> ConvexHullCalculator::computeHull(const BasicPointSpan<int64_t> &);
 
-    // Construct the convex hull using a stack
-    std::vector<Point> hull;
-    hull.push_back(points[0]);
+std::vector<Point> ConvexHullCalculator::computeHull(const std::vector<Point> &points) {
+    PointStore store(points);
+    return computeHull(store.span());
+}
 
-    // Handle collinear points and ensure we have at least 2 points if available
-    if (n > 1) {
-        hull.push_back(points[1]);
+bool ConvexHullCalculator::parseEngine(std::string_view name, HullEngine &out) {
+    if (name == "graham") {
+        out = HullEngine::Graham;
+    } else if (name == "monotone") {
+        out = HullEngine::MonotoneChain;
+    } else if (name == "chan") {
+        out = HullEngine::Chan;
+    } else if (name == "quickhull") {
+        out = HullEngine::Quickhull;
+    } else if (name == "auto") {
+        out = HullEngine::Auto;
+    } else {
+        return false;
     }
+    return true;
+}
 
-    for (int i = 2; i < n; ++i) {
-        while (hull.size() > 1 && crossProduct(hull[hull.size() - 2], hull.back(), points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
+const char *ConvexHullCalculator::engineName(HullEngine engine) {
+    switch (engine) {
+        case HullEngine::MonotoneChain:
+            return "monotone";
+        case HullEngine::Chan:
+            return "chan";
+        case HullEngine::Quickhull:
+            return "quickhull";
+        case HullEngine::Auto:
+            return "auto";
+        case HullEngine::Graham:
+        default:
+            return "graham";
     }
+}
 
-    return hull;
+bool ConvexHullCalculator::parseCoordType(std::string_view name, CoordType &out) {
+    if (name == "double") {
+        out = CoordType::Double;
+    } else if (name == "float") {
+        out = CoordType::Float;
+    } else if (name == "int32") {
+        out = CoordType::Int32;
+    } else if (name == "int64") {
+        out = CoordType::Int64;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *ConvexHullCalculator::coordTypeName(CoordType type) {
+    switch (type) {
+        case CoordType::Float:
+            return "float";
+        case CoordType::Int32:
+            return "int32";
+        case CoordType::Int64:
+            return "int64";
+        case CoordType::Double:
+        default:
+            return "double";
+    }
+}
+
+size_t ConvexHullCalculator::size() const {
+    return std::visit([](const auto &store) { return store.total(); }, points);
+}
+
+size_t ConvexHullCalculator::distinctSize() const {
+    return std::visit([](const auto &store) { return store.size(); }, points);
+}
+
+void ConvexHullCalculator::setDedup(bool enabled) {
+    dedup = enabled;
+    std::visit([enabled](auto &store) { store.setDedup(enabled); }, points);
+    // the same points either way, so the hull stays valid
+    touch(false);
 }
 
 double ConvexHullCalculator::calculateArea(const std::vector<Point> &hull) {
     if (hull.size() < 3) return 0.0; // A polygon needs at least 3 vertices
 
-    double area = 0.0;
-    for (int i = 0; i < hull.size(); ++i) {
-        int j = (i + 1) % hull.size();
-        area += hull[i].x * hull[j].y - hull[j].x * hull[i].y;
+    return std::abs(shoelaceSum(hull.data(), hull.size())) / 2.0;
+}
+
+void ConvexHullCalculator::resetPoints(CoordType type) {
+    if (type == getCoordType()) {
+        std::visit([](auto &store) { store.clear(); }, points);
+        return;
+    }
+    switch (type) {
+        case CoordType::Float:
+            points.emplace<IndexedPointStore<float> >();
+            break;
+        case CoordType::Int32:
+            points.emplace<IndexedPointStore<int32_t> >();
+            break;
+        case CoordType::Int64:
+            points.emplace<IndexedPointStore<int64_t> >();
+            break;
+        case CoordType::Double:
+        default:
+            points.emplace<IndexedPointStore<double> >();
     }
+    std::visit([this](auto &store) { store.setDedup(dedup); }, points);
+}
 
-    return std::abs(area) / 2.0;
+void ConvexHullCalculator::rebuildHull() {
+    // the hull is exact in the graph's coordinate type; dynamicHull and the area work in double
+    std::vector<Point> hull = std::visit([this](const auto &store) { return computeHull(store.span()); }, points);
+    dynamicHull.assign(hull);
+    if (getCoordType() == CoordType::Int64) {
+        // dynamicHull may merge int64 vertices that round to the same double, so the engine's
+        // hull is kept as it is; int64 graphs never update dynamicHull in between
+        hullCache.swap(hull);
+        hullCacheVersion = hullVersion;
+    }
+    hullValid = true;
 }
 
-void ConvexHullCalculator::commandNewGraph(int n) {
-    points.resize(n);
+bool ConvexHullCalculator::isHullVertex(const Point &p) {
+    if (getCoordType() == CoordType::Int64) {
+        // compared after rounding to double, so a point that only rounds to a vertex counts as
+        // one too and costs a rebuild rather than a wrong hull
+        const std::vector<Point> &hull = getHull();
+        return std::find_if(hull.begin(), hull.end(), [&p](const Point &vertex) {
+            return vertex.x == p.x && vertex.y == p.y;
+        }) != hull.end();
+    }
+    return dynamicHull.isVertex(p);
 }
 
-void ConvexHullCalculator::commandNewGraph(int n, const std::vector<std::string> &pointStrings) {
-    points.clear();
-    for (int i = 0; i < n && i < pointStrings.size(); ++i) {
-        points.push_back(parsePoint(pointStrings[i]));
+void ConvexHullCalculator::touch(bool hullChanged) {
+    version++;
+    if (hullChanged) {
+        hullVersion++;
     }
 }
 
-double ConvexHullCalculator::commandCalculateHull() {
-    if (points.empty()) {
-        return 0.0;
+const std::vector<Point> &ConvexHullCalculator::getHull() {
+    if (!hullValid) {
+        rebuildHull();
     }
-    std::vector<Point> hull = grahamScan(points);
-    return calculateArea(hull);
+    if (hullCacheVersion != hullVersion) {
+        hullCache = dynamicHull.vertices();
+        hullCacheVersion = hullVersion;
+    }
+    return hullCache;
 }
 
-void ConvexHullCalculator::commandAddPoint(const std::string &pointStr) {
-    // Remove leading whitespace if present
-    std::string trimmedStr = pointStr;
-    trimmedStr.erase(0, trimmedStr.find_first_not_of(" \t"));
+void ConvexHullCalculator::commandNewGraph(int n, CoordType type) {
+    resetPoints(type);
+    std::visit([n](auto &store) { store.resize(n); }, points);
+    hullValid = false;
+    touch(true);
+}
 
-    Point newPoint = parsePoint(trimmedStr);
-    points.push_back(newPoint);
+void ConvexHullCalculator::commandNewGraph(int n, const std::vector<std::string> &pointStrings, CoordType type) {
+    resetPoints(type);
+    std::visit([&](auto &store) {
+        typename std::decay<decltype(store)>::type::value_type x, y;
+        store.reserve(std::min(static_cast<size_t>(n), pointStrings.size()));
+        for (size_t i = 0; i < static_cast<size_t>(n) && i < pointStrings.size(); ++i) {
+            if (parsePointText(pointStrings[i], x, y) == ParseStatus::Ok) {
+                store.push_back(x, y);
+            }
+        }
+    }, points);
+    // bulk loads are cheaper to scan once on the next CH than to insert point by point
+    hullValid = false;
+    touch(true);
 }
 
-void ConvexHullCalculator::commandAddPoint(Point new_point) {
-    points.push_back(new_point);
+LineParseResult ConvexHullCalculator::commandNewGraph(int n, std::string_view lines, CoordType type) {
+    resetPoints(type);
+    LineParseResult result = std::visit([&](auto &store) {
+        typedef typename std::decay<decltype(store)>::type::value_type Coord;
+        return parsePointLines<Coord>(lines, static_cast<size_t>(n), [&store](Coord x, Coord y) {
+            store.push_back(x, y);
+        });
+    }, points);
+    hullValid = false;
+    touch(true);
+    return result;
 }
 
-bool ConvexHullCalculator::commandRemovePoint(const std::string &pointStr) {
-    // Remove leading whitespace if present
-    std::string trimmedStr = pointStr;
-    trimmedStr.erase(0, trimmedStr.find_first_not_of(" \t"));
+bool ConvexHullCalculator::commandLoadPoints(CoordType type, const void *x, const void *y, size_t n) {
+    if (!coordinatesInRange(type, x, y, n)) {
+        return false;
+    }
+    resetPoints(type);
+    std::visit([&](auto &store) {
+        typedef typename std::decay<decltype(store)>::type::value_type Coord;
+        store.assign(static_cast<const Coord *>(x), static_cast<const Coord *>(y), n);
+    }, points);
+    hullValid = false;
+    touch(true);
+    return true;
+}
 
-    Point targetPoint = parsePoint(trimmedStr);
+std::string ConvexHullCalculator::graphDirectory;
 
-    // Find and remove the point if it exists
-    auto it = std::find(points.begin(), points.end(), targetPoint);
-    if (it != points.end()) {
-        points.erase(it);
-        return true;
+bool ConvexHullCalculator::commandLoadGraph(const std::string &path, std::string &error) {
+    std::shared_ptr<MappedGraphFile> file = std::make_shared<MappedGraphFile>();
+    if (!file->open(path, error)) {
+        return false;
     }
-    return false;
+    resetPoints(file->coordType());
+    std::visit([&file](auto &store) {
+        typedef typename std::decay<decltype(store)>::type::value_type Coord;
+        // the store reads the mapping in place, like its own aligned arrays, until it grows
+        store.adopt(static_cast<Coord *>(file->x()), static_cast<Coord *>(file->y()), file->size(), file);
+    }, points);
+    hullValid = false;
+    touch(true);
+    return true;
 }
 
-std::string ConvexHullCalculator::processCommand(const std::string &command, std::vector<std::string> &followupLines) {
-    std::istringstream iss(command);
-    std::string cmd;
-    iss >> cmd;
+bool ConvexHullCalculator::commandSaveGraph(const std::string &path, std::string &error) {
+    return std::visit([&](const auto &store) {
+        typedef typename std::decay<decltype(store)>::type::value_type Coord;
+        BasicPointSpan<Coord> span = store.span();
+        BasicPointStore<Coord> expanded;
+        if (store.total() != store.size()) {
+            // the format has no multiplicities
+            expanded.reserve(store.total());
+            for (size_t i = 0; i < span.size; ++i) {
+                for (uint32_t copy = 0; copy < store.multiplicity(i); ++copy) {
+                    expanded.push_back(span.x[i], span.y[i]);
+                }
+            }
+            span = expanded.span();
+        }
+        return writeGraphFile(path, CoordTraits<Coord>::type, span.x, span.y, span.size, error);
+    }, points);
+}
 
-    if (cmd == "Newgraph") {
-        int n;
-        iss >> n;
-        commandNewGraph(n, followupLines);
-        return "Graph created with " + std::to_string(n) + " points.";
+bool ConvexHullCalculator::resolveGraphFile(const std::string &name, std::string &path, std::string &error) {
+    if (graphDirectory.empty()) {
+        error = "graph files are disabled";
+        return false;
     }
-    if (cmd == "CH") {
-        double area = commandCalculateHull();
-        return std::to_string(area);
+    // a bare file name, so a client never leaves the directory
+    if (name.empty() || name[0] == '.' || name.find('/') != std::string::npos) {
+        error = "invalid file name";
+        return false;
     }
-    if (cmd == "Newpoint") {
-        std::string pointStr;
-        std::getline(iss, pointStr); // Get the rest of the line
-        commandAddPoint(pointStr);
-        return "Point added.";
+    path = graphDirectory + "/" + name;
+    return true;
+}
+
+void ConvexHullCalculator::processFileCommand(Command command, std::string_view name, std::string &out) {
+    std::string_view cmd = commandName(command);
+    if (name.empty()) {
+        out.append("Usage: ").append(cmd).append(" <file>");
+        return;
     }
-    if (cmd == "Removepoint") {
-        std::string pointStr;
-        std::getline(iss, pointStr); // Get the rest of the line
-        bool removed = commandRemovePoint(pointStr);
-        if (removed) {
-            return "Point removed.";
-        }
-        return "Point not found.";
+    std::string path, error;
+    bool load = command == Command::Loadgraph;
+    if (!resolveGraphFile(std::string(name), path, error) ||
+        !(load ? commandLoadGraph(path, error) : commandSaveGraph(path, error))) {
+        out.append(cmd).append(" failed: ").append(error).append(".");
+        return;
     }
-    if (cmd == "help") {
-        return "Commands: Newgraph n, CH, Newpoint x,y, Removepoint x,y, help, exit";
+    out += load ? "Graph loaded with " : "Graph saved with ";
+    appendInteger(out, size());
+    out += " points.";
+}
+
+double ConvexHullCalculator::commandCalculateHull() {
+    if (size() == 0) {
+        return 0.0;
     }
-    if (cmd == "exit") {
-        return "exit";
+    if (!hullValid) {
+        rebuildHull();
     }
-    return "Unknown command. Type 'help' for available commands.";
+    if (getCoordType() == CoordType::Int64) {
+        return calculateArea(getHull());
+    }
+    return dynamicHull.area();
 }
 
-std::string ConvexHullCalculator::processCommand(const std::string &command) {
-    std::istringstream iss(command);
-    std::string cmd;
-    iss >> cmd;
-
-    if (cmd == "Newgraph") {
-        int n;
-        iss >> n;
-        commandNewGraph(n);
-        return "Graph created with " + std::to_string(n) + " points.";
+bool ConvexHullCalculator::insertIntoHull(const Point &added) {
+    if (!hullValid) {
+        // the next rebuild picks the point up anyway
+        return true;
     }
-    if (cmd == "CH") {
-        double area = commandCalculateHull();
-        return std::to_string(area);
+    if (getCoordType() == CoordType::Int64) {
+        // dynamicHull works in double, which is not exact for int64 coordinates beyond 2^53, so
+        // the exact engine redoes the hull on the next read instead
+        hullValid = false;
+        return true;
     }
-    if (cmd == "Newpoint") {
-        std::string pointStr;
-        std::getline(iss, pointStr); // Get the rest of the line
-        commandAddPoint(pointStr);
-        return "Point added.";
+    return dynamicHull.insert(added);
+}
+
+ParseStatus ConvexHullCalculator::commandAddPoint(std::string_view pointStr) {
+    Point added;
+    ParseStatus status = std::visit([&](auto &store) {
+        typename std::decay<decltype(store)>::type::value_type x, y;
+        ParseStatus parsed = parsePointText(pointStr, x, y);
+        if (parsed == ParseStatus::Ok) {
+            added = store.at(store.push_back(x, y));
+        }
+        return parsed;
+    }, points);
+    if (status == ParseStatus::Ok) {
+        touch(insertIntoHull(added));
     }
-    if (cmd == "Removepoint") {
-        std::string pointStr;
-        std::getline(iss, pointStr); // Get the rest of the line
-        bool removed = commandRemovePoint(pointStr);
-        if (removed) {
-            return "Point removed.";
+    return status;
+}
+
+void ConvexHullCalculator::commandAddPoint(Point new_point) {
+    Point added = std::visit([&](auto &store) {
+        return store.at(store.push_back(new_point));
+    }, points);
+    touch(insertIntoHull(added));
+}
+
+bool ConvexHullCalculator::commandRemovePoint(std::string_view pointStr) {
+    // Find and remove the point if it exists; one that does not parse is in no graph
+    return std::visit([&](auto &store) {
+        typename std::decay<decltype(store)>::type::value_type x, y;
+        if (parsePointText(pointStr, x, y) != ParseStatus::Ok) {
+            return false;
+        }
+        size_t index = store.find(x, y);
+        if (index == store.size()) {
+            return false;
+        }
+        // removing an interior point, or one copy of a repeated point, leaves the hull as it is
+        bool hullChanged = store.multiplicity(index) == 1 && (!hullValid || isHullVertex(store.at(index)));
+        if (hullChanged) {
+            hullValid = false;
         }
-        return "Point not found.";
+        store.removeCopy(index);
+        touch(hullChanged);
+        return true;
+    }, points);
+}
+
+bool ConvexHullCalculator::commandCountRegion(Region region, std::string_view args, size_t &count) {
+    return std::visit([&](auto &store) {
+        regionHits.clear();
+        if (!findInRegion(store, region, args, regionHits, regionCandidates)) {
+            return false;
+        }
+        count = 0;
+        for (PointIndex i: regionHits) {
+            count += store.multiplicity(i);
+        }
+        return true;
+    }, points);
+}
+
+bool ConvexHullCalculator::commandRemoveRegion(Region region, std::string_view args, size_t &removed) {
+    return std::visit([&](auto &store) {
+        std::vector<PointIndex> &inside = regionHits;
+        inside.clear();
+        if (!findInRegion(store, region, args, inside, regionCandidates)) {
+            return false;
+        }
+        if (inside.empty()) {
+            removed = 0;
+            return true;
+        }
+        size_t before = store.total();
+        // from the highest position down: swapRemove moves the last point, which is never one
+        // still to be removed
+        std::sort(inside.begin(), inside.end(), std::greater<PointIndex>());
+        bool hullChanged = !hullValid;
+        for (PointIndex i: inside) {
+            hullChanged = hullChanged || isHullVertex(store.at(i));
+            store.swapRemove(i);
+        }
+        removed = before - store.total();
+        if (hullChanged) {
+            hullValid = false;
+        }
+        touch(hullChanged);
+        return true;
+    }, points);
+}
+
+void ConvexHullCalculator::appendDedupStats(std::string &out) const {
+    if (!dedup) {
+        out += ", dedup: off";
+        return;
     }
-    if (cmd == "exit" || cmd.empty()) {
-        return "exit";
+    size_t distinct = distinctSize();
+    // points per distinct point: 1 when nothing repeats
+    double ratio = distinct == 0 ? 1.0 : static_cast<double>(size()) / distinct;
+    out += ", dedup: on, distinct: ";
+    appendInteger(out, distinct);
+    out += " of ";
+    appendInteger(out, size());
+    out += ", dedup ratio: ";
+    appendFixed(out, ratio);
+}
+
+void ConvexHullCalculator::processRegionCommand(Command command, std::string_view args, std::string &out) {
+    bool remove = command == Command::Removerect || command == Command::Removecircle;
+    Region region = command == Command::Removerect || command == Command::Countrect ? Region::Rect : Region::Circle;
+    size_t count = 0;
+    bool valid = remove ? commandRemoveRegion(region, args, count) : commandCountRegion(region, args, count);
+    if (!valid) {
+        std::string_view cmd = commandName(command);
+        out.append("Invalid ").append(cmd).append(" command. Usage: ").append(cmd);
+        out += region == Region::Rect ? " x1,y1,x2,y2" : " x,y,r";
+        return;
     }
+    if (remove) {
+        out += "Removed ";
+        appendInteger(out, count);
+        out += " points.";
+        return;
+    }
+    appendInteger(out, count);
+}
 
-    return "Unknown command.";
+void ConvexHullCalculator::dispatch(Command command, std::string_view args, std::string &out) {
+    switch (command) {
+        case Command::Newgraph: {
+            std::string_view count = nextToken(args);
+            std::string_view typeName = nextToken(args);
+            int n = -1;
+            CoordType type = CoordType::Double;
+            std::from_chars(count.data(), count.data() + count.size(), n);
+            if (n < 0) {
+                out += "Invalid Newgraph command. Usage: Newgraph n [double|float|int32|int64]";
+            } else if (!typeName.empty() && !parseCoordType(typeName, type)) {
+                out += "Unknown coordinate type. Usage: Newgraph n [double|float|int32|int64]";
+            } else {
+                commandNewGraph(n, type);
+                out += "Graph created with ";
+                appendInteger(out, n);
+                out += " points.";
+            }
+            return;
+        }
+        case Command::CH:
+            appendFixed(out, commandCalculateHull());
+            return;
+        case Command::Newpoint: {
+            ParseStatus status = commandAddPoint(args);
+            if (status != ParseStatus::Ok) {
+                out.append("Invalid point: ").append(parseStatusMessage(status)).append(". Usage: Newpoint x,y");
+                return;
+            }
+            out += "Point added.";
+            return;
+        }
+        case Command::Removepoint:
+            out += commandRemovePoint(args) ? "Point removed." : "Point not found.";
+            return;
+        case Command::Loadgraph:
+        case Command::Savegraph:
+            processFileCommand(command, nextToken(args), out);
+            return;
+        case Command::Removerect:
+        case Command::Countrect:
+        case Command::Removecircle:
+        case Command::Countcircle:
+            processRegionCommand(command, args, out);
+            return;
+        case Command::Version:
+            appendInteger(out, version);
+            return;
+        case Command::Engine: {
+            std::string_view name = nextToken(args);
+            HullEngine selected;
+            if (name.empty()) {
+                out += engineName(engine);
+            } else if (!parseEngine(name, selected)) {
+                out += "Unknown engine. Usage: Engine graham|monotone|chan|quickhull|auto";
+            } else {
+                engine = selected;
+                out.append("Engine set to ").append(engineName(engine)).append(".");
+            }
+            return;
+        }
+        case Command::Stats:
+            out += "points: ";
+            appendInteger(out, stats.inputPoints);
+            out += ", culled: ";
+            appendInteger(out, stats.culledPoints);
+            out += ", threads: ";
+            appendInteger(out, stats.threads);
+            out.append(", engine: ").append(engineName(stats.engine));
+            out.append(", sorted: ").append(stats.sortedInput ? "yes" : "no");
+            out += ", sampled hull fraction: ";
+            appendFixed(out, stats.sampledHullFraction);
+            out.append(", coords: ").append(coordTypeName(getCoordType()));
+            appendDedupStats(out);
+            return;
+        case Command::Prefilter:
+        case Command::Dedup: {
+            std::string_view mode = nextToken(args);
+            if (mode != "on" && mode != "off") {
+                out.append("Usage: ").append(commandName(command)).append(" on|off");
+                return;
+            }
+            if (command == Command::Prefilter) {
+                prefilter = mode == "on";
+            } else {
+                setDedup(mode == "on");
+            }
+            out.append(commandName(command)).append(" ").append(mode).append(".");
+            return;
+        }
+        case Command::Threads: {
+            std::string_view count = nextToken(args);
+            long threads = -1;
+            std::from_chars(count.data(), count.data() + count.size(), threads);
+            if (threads < 0 || threads > 1024) {
+                out += "Usage: Threads n (0 for one per core, 1 for serial)";
+                return;
+            }
+            parallelThreads = static_cast<unsigned>(threads);
+            out += "Threads set to ";
+            appendInteger(out, threads);
+            out += ".";
+            return;
+        }
+        case Command::Help:
+            out += "Commands: Newgraph n [double|float|int32|int64], Loadgraph file, Savegraph file, CH, Newpoint x,y, Removepoint x,y, Removerect x1,y1,x2,y2, Countrect x1,y1,x2,y2, Removecircle x,y,r, Countcircle x,y,r, Version, Engine [graham|monotone|chan|quickhull|auto], Prefilter on|off, Dedup on|off, Threads n, Stats, help, exit";
+            return;
+        case Command::Exit:
+            out += "exit";
+            return;
+        default:
+            out += "Unknown command. Type 'help' for available commands.";
+            return;
+    }
+}
+
+void ConvexHullCalculator::processCommand(std::string_view line, std::string &out) {
+    std::string_view command = nextToken(line);
+    // an empty line ends the session like exit
+    dispatch(command.empty() ? Command::Exit : lookupCommand(command), line, out);
+}
+
+std::string ConvexHullCalculator::processCommand(const std::string &command) {
+    std::string reply;
+    processCommand(std::string_view(command), reply);
+    return reply;
 }
@@ -9,64 +9,267 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <variant>
+#include "Point.hpp"
+#include "DynamicHull.hpp"
+#include "RadixSort.hpp"
+#include "HullPrefilter.hpp"
+#include "GeometryKernels.hpp"
+#include "PointStore.hpp"
+#include "PointHash.hpp"
+#include "GraphFile.hpp"
+#include "PointParser.hpp"
+#include "CommandTable.hpp"
+#include "HullCore.hpp"
 
-// Point structure needed by the ConvexHullCalculator
-struct Point {
-    double x, y;
+// Algorithm used to compute the hull from scratch
+enum class HullEngine {
+    Graham,        // polar-angle sort around the lowest point
+    MonotoneChain, // Andrew's monotone chain over a radix sort by (x, y)
+    Chan,          // output-sensitive O(n log h): Jarvis march over hulls of small groups
+    Quickhull,     // recursive farthest-point partitioning
+    Auto           // Quickhull or MonotoneChain per call, see selectEngine
+};
 
-    Point(double _x = 0, double _y = 0) : x(_x), y(_y) {}
+// Shape of the area a region command acts on
+enum class Region {
+    Rect,  // "x1,y1,x2,y2": opposite corners, bounds included
+    Circle // "x,y,r": center and radius, boundary included
+};
 
-    bool operator==(const Point& other) const {
-        return (fabs(x - other.x) < 1e-9 && fabs(y - other.y) < 1e-9);
-    }
+// What the last hull computation did
+struct HullStats {
+    size_t inputPoints = 0;  // points handed to computeHull
+    size_t culledPoints = 0; // dropped by the prefilter before the engine ran
+    unsigned threads = 1;    // chunks hulled concurrently, 1 for the serial path
+    HullEngine engine = HullEngine::Graham; // engine that ran (of the first chunk when parallel)
+    bool sortedInput = false;               // the engine input was already in (x, y) order
+    double sampledHullFraction = 0.0;       // hull share of the selector's sample, 0 if not sampled
 };
 
 class ConvexHullCalculator {
 private:
-    std::vector<Point> points;
+    // Points of the graph in the coordinate type picked by the last Newgraph; the alternatives
+    // are in CoordType order. Their order is not kept: Removepoint swaps the last point in
+    std::variant<IndexedPointStore<double>, IndexedPointStore<float>, IndexedPointStore<int32_t>,
+                 IndexedPointStore<int64_t> > points;
+
+    // Hull of points, kept up to date on every add while hullValid is set
+    DynamicHull dynamicHull;
+    bool hullValid;
+
+    // Engine used by rebuildHull
+    HullEngine engine;
+
+    // Run aklToussaintFilter before the engine
+    bool prefilter;
+
+    // Collapse repeated points into one with a multiplicity as they are added, so the engines
+    // only see distinct points
+    bool dedup;
+
+    HullStats stats;
+
+    // Worker count for large inputs, 0 for one per core, 1 to stay serial
+    unsigned parallelThreads;
+    // Inputs smaller than this are always hulled serially
+    size_t parallelThreshold;
+
+    // Prefilter and engine on one range of points. Returns the hull as positions in range and
+    // fills culledPoints, engine, sortedInput and sampledHullFraction of rangeStats
+    template <typename Coord>
+    std::vector<PointIndex> hullOfRange(const BasicPointSpan<Coord>& range, HullStats& rangeStats);
+
+    // Picks the engine for points from their count, whether they are sorted and the hull share
+    // of a strided sample, and records those in rangeStats
+    template <typename Coord>
+    HullEngine selectEngine(const BasicPointSpan<Coord>& points, HullStats& rangeStats);
+
+    // Splits points into one chunk per thread, hulls the chunks concurrently and merges the
+    // partial hulls with the monotone chain, in the coordinate type of the points
+    template <typename Coord>
+    std::vector<Point> parallelHull(const BasicPointSpan<Coord>& points, unsigned threads);
+
+    // Empties points and switches them to the given coordinate type
+    void resetPoints(CoordType type);
+
+    // Recomputes the hull of all points with the selected engine and reloads dynamicHull
+    void rebuildHull();
 
-    // Function to calculate the cross product of vectors p1p2 and p1p3
-    double crossProduct(const Point& p1, const Point& p2, const Point& p3);
+    // Adds a point just stored to the maintained hull. Returns true if the hull may have changed
+    bool insertIntoHull(const Point& added);
 
-    // Function to calculate the square of the distance between two points
-    double distanceSquared(const Point& p1, const Point& p2);
+    // p is a vertex of the valid hull, so removing it changes the hull
+    bool isHullVertex(const Point& p);
 
-    // Function to parse a point from a string (format: "x,y")
-    Point parsePoint(const std::string& str);
+    // Bumped on every change to points
+    uint64_t version;
+    // Bumped every time the hull itself changes (a point outside it, a rebuild)
+    uint64_t hullVersion;
+
+    // Hull vertices as of hullCacheVersion, refreshed lazily by getHull()
+    std::vector<Point> hullCache;
+    uint64_t hullCacheVersion;
+
+    // Records a change to points, and to the hull if hullChanged
+    void touch(bool hullChanged);
+
+    // Scratch positions of the region commands, kept so a query does not allocate once they grew
+    std::vector<PointIndex> regionHits;
+    std::vector<PointIndex> regionCandidates;
+
+    // Appends the dedup part of the Stats reply: off, or the distinct and total point counts and
+    // their ratio
+    void appendDedupStats(std::string& out) const;
+
+    // Directory Loadgraph and Savegraph resolve file names in, empty while they are off
+    static std::string graphDirectory;
+
+    // Path of the graph file name in graphDirectory. Returns false and sets error if graph files
+    // are off or name is not a plain file name
+    static bool resolveGraphFile(const std::string& name, std::string& path, std::string& error);
+
+    // Handles Loadgraph and Savegraph with their file name
+    void processFileCommand(Command command, std::string_view name, std::string& out);
+
+    // Handles Removerect, Countrect, Removecircle and Countcircle with their arguments
+    void processRegionCommand(Command command, std::string_view args, std::string& out);
 
 public:
     // Constructor
-    ConvexHullCalculator(){}
+    ConvexHullCalculator() : hullValid(false), engine(HullEngine::Auto), prefilter(true), dedup(false), parallelThreads(0), parallelThreshold(1 << 18), version(0), hullVersion(0), hullCacheVersion(0) {}
 
     // Graham Scan algorithm to find the convex hull
     std::vector<Point> grahamScan(std::vector<Point> points);
 
+    // Andrew's monotone chain: same hull as grahamScan, counter-clockwise from the leftmost point
+    std::vector<Point> monotoneChain(std::vector<Point> points);
+
+    // Chan's algorithm: same hull as monotoneChain, in O(n log h) for h hull vertices
+    std::vector<Point> chanHull(std::vector<Point> points);
+
+    // Quickhull: same hull as monotoneChain, fastest when most points are interior
+    std::vector<Point> quickhull(std::vector<Point> points);
+
+    // Hull of points with the selected engine, behind the prefilter if it is on. Reads the
+    // arrays in place; the engines only reorder indices into them. Instantiated for the
+    // coordinate types of CoordType
+    template <typename Coord>
+    std::vector<Point> computeHull(const BasicPointSpan<Coord>& points);
+
+    // Same, for points not already in a PointStore
+    std::vector<Point> computeHull(const std::vector<Point>& points);
+
+    void setPrefilter(bool enabled) { prefilter = enabled; }
+
+    // Turns duplicate collapsing on or off for this and later graphs; the points already in the
+    // graph are collapsed or expanded on the spot
+    void setDedup(bool enabled);
+
+    void setParallelThreads(unsigned threads) { parallelThreads = threads; }
+
+    void setParallelThreshold(size_t threshold) { parallelThreshold = threshold; }
+
+    const HullStats& getStats() const { return stats; }
+
+    void setEngine(HullEngine newEngine) { engine = newEngine; }
+
+    HullEngine getEngine() const { return engine; }
+
+    // Parses "graham", "monotone", "chan", "quickhull" or "auto". Returns false for anything else
+    static bool parseEngine(std::string_view name, HullEngine& out);
+
+    static const char* engineName(HullEngine engine);
+
+    // Parses "double", "float", "int32" or "int64". Returns false for anything else
+    static bool parseCoordType(std::string_view name, CoordType& out);
+
+    static const char* coordTypeName(CoordType type);
+
+    CoordType getCoordType() const { return static_cast<CoordType>(points.index()); }
+
+    // Points in the graph, repeats included
+    size_t size() const;
+
+    // Distinct points in the graph, size() unless dedup is on
+    size_t distinctSize() const;
+
     // Calculate area of the convex hull using the Shoelace formula
     double calculateArea(const std::vector<Point>& hull);
 
     // Command: Create a new graph with n points
-    void commandNewGraph(int n);
+    void commandNewGraph(int n, CoordType type = CoordType::Double);
 
     // Command: Create a new graph with n points
-    void commandNewGraph(int n, const std::vector<std::string>& pointStrings);
+    void commandNewGraph(int n, const std::vector<std::string>& pointStrings, CoordType type = CoordType::Double);
+
+    // Command: Create a new graph from the first n "x,y" lines of lines, parsed in place in one
+    // pass. Malformed lines are skipped and reported in the result
+    LineParseResult commandNewGraph(int n, std::string_view lines, CoordType type = CoordType::Double);
+
+    // Command: Replace the graph with the n points of the packed coordinate arrays x and y,
+    // aligned for the given coordinate type. Each array is copied in one go unless dedup is on.
+    // Returns false, leaving the graph as it was, if an integer coordinate is beyond its limit
+    bool commandLoadPoints(CoordType type, const void* x, const void* y, size_t n);
+
+    // Directory the Loadgraph and Savegraph commands of every calculator in the process read and
+    // write in. Empty, the default, turns both off, so the clients of a server only reach the
+    // file system if it was started with a directory
+    static void setGraphDirectory(const std::string& directory) { graphDirectory = directory; }
+
+    // Command: Replace the graph with the points of a graph file, in the file's coordinate type.
+    // The graph reads the mapped file in place rather than copying it. Returns false and sets
+    // error if it cannot be loaded
+    bool commandLoadGraph(const std::string& path, std::string& error);
+
+    // Command: Write the graph to a graph file, every copy of a repeated point included.
+    // Returns false and sets error if it cannot be written
+    bool commandSaveGraph(const std::string& path, std::string& error);
 
     // Command: Calculate and display the convex hull area
     double commandCalculateHull();
 
-    // Command: Add a new point to the current graph
-    void commandAddPoint(const std::string& pointStr);
+    // Hull vertices in counter-clockwise order, recomputed only after the hull changed
+    const std::vector<Point>& getHull();
+
+    // Modification counter of the graph: equal values mean nothing changed in between
+    uint64_t getVersion() const { return version; }
+
+    // Counter of changes to the hull; a point added inside the hull does not bump it
+    uint64_t getHullVersion() const { return hullVersion; }
+
+    // Command: Add a new point to the current graph. A point that does not parse as the graph's
+    // coordinate type is not added, and the reason returned
+    ParseStatus commandAddPoint(std::string_view pointStr);
 
     void commandAddPoint(Point new_point);
     // Command: Remove a point from the current graph
-    bool commandRemovePoint(const std::string& pointStr);
+    bool commandRemovePoint(std::string_view pointStr);
+
+    // Command: Count the points in a region, found through a grid index without scanning the
+    // rest. Returns false if args does not describe a region of the graph's coordinate type
+    bool commandCountRegion(Region region, std::string_view args, size_t& count);
+
+    // Command: Remove every point in a region. The hull is recomputed only if one of them was a
+    // hull vertex. Returns false if args does not describe a region
+    bool commandRemoveRegion(Region region, std::string_view args, size_t& removed);
+
+    // Runs command, already looked up, with the rest of its line args and appends the reply,
+    // without a newline, to out. Replies are formatted in place, so a command that does not grow
+    // the graph allocates nothing once out has room
+    void dispatch(Command command, std::string_view args, std::string& out);
+
+    // Process a command line: its first token is looked up and the reply appended to out
+    void processCommand(std::string_view line, std::string& out);
 
+    // processCommand returning the reply
     std::string processCommand(const std::string& command);
-    // Process a command from a string
-    std::string processCommand(const std::string& command, std::vector<std::string>& followupLines);
 };
 
 #endif // CONVEX_HULL_CALCULATOR_H
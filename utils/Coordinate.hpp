@@ -0,0 +1,102 @@
+//
+// Coordinate types a graph can store, and the arithmetic the hull engines use for each.
+//
+
+#ifndef COORDINATE_HPP
+#define COORDINATE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Coordinate type of a graph, chosen per graph with "Newgraph n <type>"
+enum class CoordType {
+    Double, // the default; equality within 1e-9 like Point
+    Float,  // half the memory of Double, computed in double
+    Int32,  // exact, |coordinate| < 2^30 so orientation tests fit in int64
+    Int64   // exact, |coordinate| < 2^62 so orientation tests fit in __int128
+};
+
+// Per coordinate type: Diff holds the difference of two coordinates exactly (or as well as the
+// type allows), Wide holds a product of two Diffs and the sum of two such products, so cross
+// products and squared distances never overflow. limit bounds the accepted magnitude.
+template <typename Coord>
+struct CoordTraits;
+
+template <>
+struct CoordTraits<double> {
+    typedef double Diff;
+    typedef double Wide;
+    static const CoordType type = CoordType::Double;
+
+    static bool collinear(Wide cross) { return std::fabs(cross) < 1e-9; }
+
+    static bool equal(double a, double b) { return std::fabs(a - b) < 1e-9; }
+};
+
+template <>
+struct CoordTraits<float> {
+    typedef double Diff;
+    typedef double Wide;
+    static const CoordType type = CoordType::Float;
+
+    static bool collinear(Wide cross) { return std::fabs(cross) < 1e-9; }
+
+    static bool equal(float a, float b) { return a == b; }
+};
+
+template <>
+struct CoordTraits<int32_t> {
+    typedef int64_t Diff;
+    typedef int64_t Wide;
+    static const CoordType type = CoordType::Int32;
+    static constexpr int32_t limit = (1 << 30) - 1;
+
+    static bool collinear(Wide cross) { return cross == 0; }
+
+    static bool equal(int32_t a, int32_t b) { return a == b; }
+};
+
+template <>
+struct CoordTraits<int64_t> {
+    typedef int64_t Diff;
+    typedef __int128 Wide;
+    static const CoordType type = CoordType::Int64;
+    static constexpr int64_t limit = (static_cast<int64_t>(1) << 62) - 1;
+
+    static bool collinear(Wide cross) { return cross == 0; }
+
+    static bool equal(int64_t a, int64_t b) { return a == b; }
+};
+
+// Every coordinate of the n points in x and y is within CoordTraits<Coord>::limit, the bound the
+// text parser enforces and the exact orientation tests rely on. Always true for the floating
+// types, which have no limit
+template <typename Coord>
+bool coordinatesInRange(const Coord* x, const Coord* y, size_t n) {
+    if constexpr (std::is_integral<Coord>::value) {
+        const Coord limit = CoordTraits<Coord>::limit;
+        bool inRange = true;
+        for (size_t i = 0; i < n; ++i) {
+            // without early exit, so the pass vectorizes
+            inRange &= (x[i] >= -limit) & (x[i] <= limit) & (y[i] >= -limit) & (y[i] <= limit);
+        }
+        return inRange;
+    }
+    return true;
+}
+
+// Same for arrays of the given coordinate type
+inline bool coordinatesInRange(CoordType type, const void* x, const void* y, size_t n) {
+    switch (type) {
+        case CoordType::Int32:
+            return coordinatesInRange(static_cast<const int32_t*>(x), static_cast<const int32_t*>(y), n);
+        case CoordType::Int64:
+            return coordinatesInRange(static_cast<const int64_t*>(x), static_cast<const int64_t*>(y), n);
+        default:
+            return true;
+    }
+}
+
+#endif //COORDINATE_HPP
@@ -0,0 +1,141 @@
+#include "DynamicHull.hpp"
+
+double HullChain::edge(double x1, double y1, double x2, double y2) {
+    return (x2 - x1) * (y1 + y2) / 2.0;
+}
+
+bool HullChain::notAbove(std::map<double, double>::const_iterator a,
+                         std::map<double, double>::const_iterator it,
+                         std::map<double, double>::const_iterator b) {
+    // cross product of a->b and a->it, non-positive when it is on or below a->b
+    return (b->first - a->first) * (it->second - a->second) -
+           (b->second - a->second) * (it->first - a->first) <= 0;
+}
+
+void HullChain::clear() {
+    chain.clear();
+    integral = 0.0;
+}
+
+bool HullChain::insert(double x, double y) {
+    auto it = chain.lower_bound(x);
+    if (it != chain.end() && it->first == x) {
+        if (y <= it->second) {
+            return false; // a point with the same x is already at least as high
+        }
+        // the new point replaces the lower one at this x
+        if (it != chain.begin()) {
+            auto prev = std::prev(it);
+            integral -= edge(prev->first, prev->second, it->first, it->second);
+        }
+        auto next = std::next(it);
+        if (next != chain.end()) {
+            integral -= edge(it->first, it->second, next->first, next->second);
+        }
+        if (it != chain.begin() && next != chain.end()) {
+            auto prev = std::prev(it);
+            integral += edge(prev->first, prev->second, next->first, next->second);
+        }
+        it = chain.erase(it);
+    } else if (it != chain.end() && it != chain.begin()) {
+        // strictly between two vertices: nothing to do unless it lies above their edge
+        auto prev = std::prev(it);
+        double cross = (it->first - prev->first) * (y - prev->second) -
+                       (it->second - prev->second) * (x - prev->first);
+        if (cross <= 0) {
+            return false;
+        }
+    }
+
+    // link the new vertex in between its neighbours
+    it = chain.emplace_hint(it, x, y);
+    auto prev = it == chain.begin() ? chain.end() : std::prev(it);
+    auto next = std::next(it);
+    if (prev != chain.end() && next != chain.end()) {
+        integral -= edge(prev->first, prev->second, next->first, next->second);
+    }
+    if (prev != chain.end()) {
+        integral += edge(prev->first, prev->second, x, y);
+    }
+    if (next != chain.end()) {
+        integral += edge(x, y, next->first, next->second);
+    }
+
+    // drop the vertices on the right that are no longer convex
+    while (next != chain.end()) {
+        auto after = std::next(next);
+        if (after == chain.end() || !notAbove(it, next, after)) {
+            break;
+        }
+        integral -= edge(x, y, next->first, next->second);
+        integral -= edge(next->first, next->second, after->first, after->second);
+        integral += edge(x, y, after->first, after->second);
+        chain.erase(next);
+        next = after;
+    }
+    // and on the left
+    while (it != chain.begin()) {
+        auto before = std::prev(it);
+        if (before == chain.begin()) {
+            break;
+        }
+        auto beforeThat = std::prev(before);
+        if (!notAbove(beforeThat, before, it)) {
+            break;
+        }
+        integral -= edge(beforeThat->first, beforeThat->second, before->first, before->second);
+        integral -= edge(before->first, before->second, x, y);
+        integral += edge(beforeThat->first, beforeThat->second, x, y);
+        chain.erase(before);
+    }
+    return true;
+}
+
+bool HullChain::contains(double x, double y) const {
+    auto it = chain.find(x);
+    return it != chain.end() && it->second == y;
+}
+
+void DynamicHull::clear() {
+    upper.clear();
+    lower.clear();
+}
+
+void DynamicHull::assign(const std::vector<Point> &points) {
+    clear();
+    for (const Point &p: points) {
+        insert(p);
+    }
+}
+
+bool DynamicHull::insert(const Point &p) {
+    bool changedUpper = upper.insert(p.x, p.y);
+    bool changedLower = lower.insert(p.x, -p.y);
+    return changedUpper || changedLower;
+}
+
+bool DynamicHull::isVertex(const Point &p) const {
+    return upper.contains(p.x, p.y) || lower.contains(p.x, -p.y);
+}
+
+std::vector<Point> DynamicHull::vertices() const {
+    std::vector<Point> hull;
+    const std::map<double, double> &up = upper.vertices();
+    const std::map<double, double> &down = lower.vertices();
+    if (up.empty()) {
+        return hull;
+    }
+    // lower chain left to right, then upper chain right to left, skipping shared endpoints
+    for (const auto &v: down) {
+        hull.emplace_back(v.first, -v.second);
+    }
+    for (auto it = up.rbegin(); it != up.rend(); ++it) {
+        Point p(it->first, it->second);
+        if ((it == up.rbegin() && p.x == hull.back().x && p.y == hull.back().y) ||
+            (std::next(it) == up.rend() && p.x == hull.front().x && p.y == hull.front().y)) {
+            continue;
+        }
+        hull.push_back(p);
+    }
+    return hull;
+}
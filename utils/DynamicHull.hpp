@@ -0,0 +1,71 @@
+//
+// Convex hull maintained under point insertion.
+//
+
+#ifndef DYNAMICHULL_HPP
+#define DYNAMICHULL_HPP
+
+#include <map>
+#include <vector>
+#include "Point.hpp"
+
+// One monotone chain of the hull, ordered by x. Stores the upper chain of the points it is
+// given (the lower chain is an upper chain of the points mirrored in y) together with the
+// signed area between the chain and the x axis, so the hull area never needs a full pass.
+class HullChain {
+private:
+    std::map<double, double> chain; // x -> y, the highest point seen for each x
+    double integral;                // sum of (x2 - x1) * (y1 + y2) / 2 over chain edges
+
+    static double edge(double x1, double y1, double x2, double y2);
+
+    // Point at position it is on or below the segment from a to b
+    static bool notAbove(std::map<double, double>::const_iterator a,
+                         std::map<double, double>::const_iterator it,
+                         std::map<double, double>::const_iterator b);
+
+public:
+    HullChain() : integral(0.0) {}
+
+    void clear();
+
+    // Adds (x, y). Returns true if the chain changed. O(log n) amortized
+    bool insert(double x, double y);
+
+    // (x, y) is exactly a vertex of the chain
+    bool contains(double x, double y) const;
+
+    double area() const { return integral; }
+
+    size_t size() const { return chain.size(); }
+
+    const std::map<double, double> &vertices() const { return chain; }
+};
+
+// Convex hull as an upper and a lower chain. Insertion is O(log n) amortized and the area is
+// read in O(1). Deleting a point that is not a hull vertex leaves the hull unchanged; deleting
+// a vertex is not supported and needs a rebuild from the remaining points.
+class DynamicHull {
+private:
+    HullChain upper;
+    HullChain lower; // upper chain of (x, -y)
+
+public:
+    void clear();
+
+    // Replaces the hull with the one spanned by points (typically an already computed hull)
+    void assign(const std::vector<Point> &points);
+
+    // Adds p. Returns true if the hull changed (p was outside or on a new extreme)
+    bool insert(const Point &p);
+
+    // p is exactly a hull vertex, so removing it changes the hull
+    bool isVertex(const Point &p) const;
+
+    double area() const { return upper.area() + lower.area(); }
+
+    // Hull vertices in counter-clockwise order, starting from the leftmost
+    std::vector<Point> vertices() const;
+};
+
+#endif //DYNAMICHULL_HPP
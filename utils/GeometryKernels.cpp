@@ -0,0 +1,209 @@
+#include "GeometryKernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GEOMETRY_KERNELS_X86 1
+#endif
+
+namespace {
+    void orientScalar(const PointSpan& points, size_t first, const Point& a, const Point& b, double* out) {
+        double ex = b.x - a.x, ey = b.y - a.y;
+        for (size_t i = first; i < points.size; ++i) {
+            out[i] = ex * (points.y[i] - a.y) - ey * (points.x[i] - a.x);
+        }
+    }
+
+    double shoelaceScalar(const Point* points, size_t n) {
+        double sum = 0.0;
+        for (size_t i = 0; i + 1 < n; ++i) {
+            sum += points[i].x * points[i + 1].y - points[i + 1].x * points[i].y;
+        }
+        return sum + points[n - 1].x * points[0].y - points[0].x * points[n - 1].y;
+    }
+
+    // Lexicographic (major, minor) of point i is smaller than that of best
+    bool lexLess(const double* major, const double* minor, size_t i, size_t best) {
+        return major[i] < major[best] || (major[i] == major[best] && minor[i] < minor[best]);
+    }
+
+#ifdef GEOMETRY_KERNELS_X86
+    __attribute__((target("avx2")))
+    size_t orientAvx2(const PointSpan& points, const Point& a, const Point& b, double* out) {
+        __m256d ax = _mm256_set1_pd(a.x), ay = _mm256_set1_pd(a.y);
+        __m256d ex = _mm256_set1_pd(b.x - a.x), ey = _mm256_set1_pd(b.y - a.y);
+        size_t i = 0;
+        for (; i + 4 <= points.size; i += 4) {
+            __m256d xs = _mm256_loadu_pd(points.x + i);
+            __m256d ys = _mm256_loadu_pd(points.y + i);
+            __m256d cross = _mm256_sub_pd(_mm256_mul_pd(ex, _mm256_sub_pd(ys, ay)),
+                                          _mm256_mul_pd(ey, _mm256_sub_pd(xs, ax)));
+            _mm256_storeu_pd(out + i, cross);
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    double shoelaceAvx2(const Point* points, size_t n) {
+        const double* raw = &points[0].x;
+        __m256d acc = _mm256_setzero_pd();
+        size_t i = 0;
+        // two edges per step: (x0, y0, x1, y1) times (y1, x1, y2, x2)
+        for (; i + 3 <= n; i += 2) {
+            __m256d cur = _mm256_loadu_pd(raw + 2 * i);
+            __m256d next = _mm256_permute_pd(_mm256_loadu_pd(raw + 2 * i + 2), 0x5);
+            acc = _mm256_add_pd(acc, _mm256_mul_pd(cur, next));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, acc);
+        double sum = (lanes[0] - lanes[1]) + (lanes[2] - lanes[3]);
+        for (; i + 1 < n; ++i) {
+            sum += points[i].x * points[i + 1].y - points[i + 1].x * points[i].y;
+        }
+        return sum + points[n - 1].x * points[0].y - points[0].x * points[n - 1].y;
+    }
+
+    // Per-lane best (major, minor) key and the index it came from
+    struct LaneBest {
+        __m256d major, minor, index;
+    };
+
+    // Takes the lanes of (major, minor) that beat best: smaller keys, or larger ones with Max
+    template<bool Max>
+    __attribute__((target("avx2")))
+    inline void laneUpdate(LaneBest& best, __m256d major, __m256d minor, __m256d index) {
+        const int beats = Max ? _CMP_GT_OQ : _CMP_LT_OQ;
+        __m256d better = _mm256_or_pd(
+            _mm256_cmp_pd(major, best.major, beats),
+            _mm256_and_pd(_mm256_cmp_pd(major, best.major, _CMP_EQ_OQ), _mm256_cmp_pd(minor, best.minor, beats)));
+        best.major = _mm256_blendv_pd(best.major, major, better);
+        best.minor = _mm256_blendv_pd(best.minor, minor, better);
+        best.index = _mm256_blendv_pd(best.index, index, better);
+    }
+
+    // Folds the lanes of several accumulators into the first index with the best key
+    template<bool Max>
+    __attribute__((target("avx2")))
+    size_t laneReduce(const LaneBest* bests, int count) {
+        size_t result = 0;
+        double major = 0, minor = 0;
+        bool found = false;
+        for (int b = 0; b < count; ++b) {
+            double majors[4], minors[4], indices[4];
+            _mm256_storeu_pd(majors, bests[b].major);
+            _mm256_storeu_pd(minors, bests[b].minor);
+            _mm256_storeu_pd(indices, bests[b].index);
+            for (int lane = 0; lane < 4; ++lane) {
+                size_t index = static_cast<size_t>(indices[lane]);
+                bool better = Max ? (majors[lane] > major || (majors[lane] == major && minors[lane] > minor))
+                                  : (majors[lane] < major || (majors[lane] == major && minors[lane] < minor));
+                bool tie = majors[lane] == major && minors[lane] == minor && index < result;
+                if (!found || better || tie) {
+                    result = index;
+                    major = majors[lane];
+                    minor = minors[lane];
+                    found = true;
+                }
+            }
+        }
+        return result;
+    }
+
+    // Lexicographic argmin (and argmax if maxIndex is set) of (major[i], minor[i]) over whole
+    // blocks of eight points, in two independent accumulators so the compare and blend chains of
+    // consecutive blocks overlap. Returns how many points were covered.
+    __attribute__((target("avx2")))
+    size_t lexExtremesAvx2(const double* major, const double* minor, size_t n, size_t& minIndex,
+                           size_t* maxIndex) {
+        size_t blocks = n / 8 * 8;
+        if (blocks == 0) {
+            return 0;
+        }
+        LaneBest mins[2], maxs[2];
+        for (int k = 0; k < 2; ++k) {
+            __m256d index = _mm256_setr_pd(4 * k, 4 * k + 1, 4 * k + 2, 4 * k + 3);
+            mins[k] = maxs[k] = {_mm256_loadu_pd(major + 4 * k), _mm256_loadu_pd(minor + 4 * k), index};
+        }
+        __m256d eight = _mm256_set1_pd(8);
+        __m256d index0 = _mm256_setr_pd(0, 1, 2, 3);
+        __m256d index1 = _mm256_setr_pd(4, 5, 6, 7);
+        for (size_t i = 8; i < blocks; i += 8) {
+            index0 = _mm256_add_pd(index0, eight);
+            index1 = _mm256_add_pd(index1, eight);
+            __m256d major0 = _mm256_loadu_pd(major + i), minor0 = _mm256_loadu_pd(minor + i);
+            __m256d major1 = _mm256_loadu_pd(major + i + 4), minor1 = _mm256_loadu_pd(minor + i + 4);
+            laneUpdate<false>(mins[0], major0, minor0, index0);
+            laneUpdate<false>(mins[1], major1, minor1, index1);
+            if (maxIndex != nullptr) {
+                laneUpdate<true>(maxs[0], major0, minor0, index0);
+                laneUpdate<true>(maxs[1], major1, minor1, index1);
+            }
+        }
+        minIndex = laneReduce<false>(mins, 2);
+        if (maxIndex != nullptr) {
+            *maxIndex = laneReduce<true>(maxs, 2);
+        }
+        return blocks;
+    }
+#endif
+}
+
+bool cpuHasAvx2() {
+#ifdef GEOMETRY_KERNELS_X86
+    static const bool avx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+void orientBatch(const PointSpan& points, const Point& a, const Point& b, double* out) {
+    size_t first = 0;
+#ifdef GEOMETRY_KERNELS_X86
+    if (cpuHasAvx2()) {
+        first = orientAvx2(points, a, b, out);
+    }
+#endif
+    orientScalar(points, first, a, b, out);
+}
+
+double shoelaceSum(const Point* points, size_t n) {
+    if (n < 3) {
+        return 0.0;
+    }
+#ifdef GEOMETRY_KERNELS_X86
+    if (cpuHasAvx2()) {
+        return shoelaceAvx2(points, n);
+    }
+#endif
+    return shoelaceScalar(points, n);
+}
+
+size_t lowestPointIndex(const PointSpan& points) {
+    size_t best = 0, first = 1;
+#ifdef GEOMETRY_KERNELS_X86
+    if (cpuHasAvx2() && points.size >= 8) {
+        first = lexExtremesAvx2(points.y, points.x, points.size, best, nullptr);
+    }
+#endif
+    for (size_t i = first; i < points.size; ++i) {
+        if (lexLess(points.y, points.x, i, best)) best = i;
+    }
+    return best;
+}
+
+void extremeXIndices(const PointSpan& points, size_t& leftmost, size_t& rightmost) {
+    leftmost = rightmost = 0;
+    size_t first = 1;
+#ifdef GEOMETRY_KERNELS_X86
+    if (cpuHasAvx2() && points.size >= 8) {
+        first = lexExtremesAvx2(points.x, points.y, points.size, leftmost, &rightmost);
+    }
+#endif
+    for (size_t i = first; i < points.size; ++i) {
+        if (lexLess(points.x, points.y, i, leftmost)) leftmost = i;
+        if (lexLess(points.x, points.y, rightmost, i)) rightmost = i;
+    }
+}
@@ -0,0 +1,52 @@
+//
+// Inner loops of the hull engines over point arrays, with an AVX2 version picked at runtime.
+//
+
+#ifndef GEOMETRYKERNELS_HPP
+#define GEOMETRYKERNELS_HPP
+
+#include <cstddef>
+#include "Point.hpp"
+#include "PointStore.hpp"
+
+// The CPU running us supports AVX2 (checked once with CPUID)
+bool cpuHasAvx2();
+
+// out[i] = cross product of a->b and a->points[i], the same value crossProduct(a, b, points[i])
+// gives: positive left of a -> b, negative right of it
+void orientBatch(const PointSpan& points, const Point& a, const Point& b, double* out);
+
+// Twice the signed area of the polygon points[0..n), counter-clockwise positive
+double shoelaceSum(const Point* points, size_t n);
+
+// Index of the first point with the smallest y, ties broken by the smallest x
+size_t lowestPointIndex(const PointSpan& points);
+
+// Indices of the first points with the smallest and the largest (x, y)
+void extremeXIndices(const PointSpan& points, size_t& leftmost, size_t& rightmost);
+
+// Scalar lowestPointIndex for the coordinate types without a SIMD version
+template <typename Coord>
+size_t lowestPointIndex(const BasicPointSpan<Coord>& points) {
+    size_t best = 0;
+    for (size_t i = 1; i < points.size; ++i) {
+        if (points.y[i] < points.y[best] || (points.y[i] == points.y[best] && points.x[i] < points.x[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Scalar extremeXIndices for the coordinate types without a SIMD version
+template <typename Coord>
+void extremeXIndices(const BasicPointSpan<Coord>& points, size_t& leftmost, size_t& rightmost) {
+    leftmost = rightmost = 0;
+    for (size_t i = 1; i < points.size; ++i) {
+        const Coord* x = points.x;
+        const Coord* y = points.y;
+        if (x[i] < x[leftmost] || (x[i] == x[leftmost] && y[i] < y[leftmost])) leftmost = i;
+        if (x[rightmost] < x[i] || (x[rightmost] == x[i] && y[rightmost] < y[i])) rightmost = i;
+    }
+}
+
+#endif //GEOMETRYKERNELS_HPP
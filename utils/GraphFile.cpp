@@ -0,0 +1,152 @@
+#include "GraphFile.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char GRAPH_FILE_MAGIC[8] = {'C', 'H', 'G', 'R', 'A', 'P', 'H', '\0'};
+
+namespace {
+    const uint64_t ALIGNMENT = 64;
+
+    uint64_t alignUp(uint64_t offset) {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    // Offset of the y coordinates of count points of size bytes each
+    uint64_t yOffsetOf(uint64_t count, size_t size) {
+        return alignUp(sizeof(GraphFileHeader) + count * size);
+    }
+
+    // Writes all of buffer to fd, retrying short writes
+    bool writeAll(int fd, const void* buffer, size_t bytes) {
+        const char* data = static_cast<const char*>(buffer);
+        while (bytes > 0) {
+            ssize_t written = write(fd, data, bytes);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            bytes -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+}
+
+size_t coordinateSize(CoordType type) {
+    switch (type) {
+        case CoordType::Float:
+        case CoordType::Int32:
+            return 4;
+        case CoordType::Double:
+        case CoordType::Int64:
+        default:
+            return 8;
+    }
+}
+
+MappedGraphFile::~MappedGraphFile() {
+    if (base != nullptr) {
+        munmap(base, length);
+    }
+}
+
+bool MappedGraphFile::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        error = std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    if (static_cast<uint64_t>(info.st_size) < sizeof(GraphFileHeader)) {
+        error = "not a graph file";
+        close(fd);
+        return false;
+    }
+    size_t fileLength = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, fileLength, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (mapped == MAP_FAILED) {
+        error = std::strerror(errno);
+        return false;
+    }
+    // the coordinates are read once, front to back, right away
+    madvise(mapped, fileLength, MADV_SEQUENTIAL);
+    madvise(mapped, fileLength, MADV_WILLNEED);
+    if (base != nullptr) {
+        munmap(base, length);
+    }
+    base = mapped;
+    length = fileLength;
+
+    const GraphFileHeader& h = header();
+    size_t size = coordinateSize(static_cast<CoordType>(h.coordType));
+    if (std::memcmp(h.magic, GRAPH_FILE_MAGIC, sizeof h.magic) != 0) {
+        error = "not a graph file";
+    } else if (h.version != GRAPH_FILE_VERSION) {
+        error = "unsupported graph file version " + std::to_string(h.version);
+    } else if (h.coordType > static_cast<uint32_t>(CoordType::Int64)) {
+        error = "unknown coordinate type";
+    } else if (h.count > INT32_MAX) {
+        error = "too many points";
+    } else if (h.yOffset != yOffsetOf(h.count, size) || length < h.yOffset + h.count * size) {
+        error = "truncated graph file";
+    } else if (!coordinatesInRange(coordType(), x(), y(), h.count)) {
+        error = "coordinates out of range";
+    } else {
+        return true;
+    }
+    munmap(base, length);
+    base = nullptr;
+    length = 0;
+    return false;
+}
+
+bool writeGraphFile(const std::string& path, CoordType type, const void* xs, const void* ys, size_t count,
+                    std::string& error) {
+    size_t size = coordinateSize(type);
+    GraphFileHeader header;
+    std::memset(&header, 0, sizeof header);
+    std::memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof header.magic);
+    header.version = GRAPH_FILE_VERSION;
+    header.coordType = static_cast<uint32_t>(type);
+    header.count = count;
+    header.yOffset = yOffsetOf(count, size);
+    const char padding[ALIGNMENT] = {};
+    size_t paddingBytes = header.yOffset - sizeof header - count * size;
+
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    bool written = writeAll(fd, &header, sizeof header) && writeAll(fd, xs, count * size) &&
+                   writeAll(fd, padding, paddingBytes) && writeAll(fd, ys, count * size);
+    if (!written) {
+        error = std::strerror(errno);
+    }
+    if (close(fd) < 0 && written) {
+        error = std::strerror(errno);
+        written = false;
+    }
+    if (written && rename(temporary.c_str(), path.c_str()) < 0) {
+        error = std::strerror(errno);
+        written = false;
+    }
+    if (!written) {
+        unlink(temporary.c_str());
+    }
+    return written;
+}
@@ -0,0 +1,71 @@
+//
+// Binary graph files: a header and the packed coordinates of every point, read through mmap.
+//
+
+#ifndef GRAPHFILE_HPP
+#define GRAPHFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Coordinate.hpp"
+
+// Layout, in native byte order: this 64-byte header, the x coordinates of every point, zero
+// padding up to a 64-byte boundary, then the y coordinates. Those are the two arrays of a
+// PointStore, so a load is one copy per array and a save one write per array.
+struct GraphFileHeader {
+    char magic[8];        // GRAPH_FILE_MAGIC
+    uint32_t version;     // GRAPH_FILE_VERSION
+    uint32_t coordType;   // CoordType of the coordinates
+    uint64_t count;       // number of points
+    uint64_t yOffset;     // offset of the y coordinates from the start of the file
+    uint8_t reserved[32]; // zero
+};
+
+static_assert(sizeof(GraphFileHeader) == 64, "the coordinates start on a 64-byte boundary");
+
+extern const char GRAPH_FILE_MAGIC[8];
+const uint32_t GRAPH_FILE_VERSION = 1;
+
+// Bytes per coordinate of the given type
+size_t coordinateSize(CoordType type);
+
+// Private copy-on-write mapping of a graph file, unmapped on destruction. The coordinates may be
+// edited in place without touching the file. writeGraphFile replaces files by renaming, never
+// rewriting them, so a mapped graph does not change under its reader when the file is saved again
+class MappedGraphFile {
+private:
+    void* base;
+    size_t length;
+
+public:
+    MappedGraphFile() : base(nullptr), length(0) {}
+
+    MappedGraphFile(const MappedGraphFile&) = delete;
+
+    MappedGraphFile& operator=(const MappedGraphFile&) = delete;
+
+    ~MappedGraphFile();
+
+    // Maps path, checks its header against the file size and its integer coordinates against
+    // their limit. Returns false and sets error if the file cannot be read or is not a graph file
+    bool open(const std::string& path, std::string& error);
+
+    const GraphFileHeader& header() const { return *static_cast<const GraphFileHeader*>(base); }
+
+    CoordType coordType() const { return static_cast<CoordType>(header().coordType); }
+
+    size_t size() const { return header().count; }
+
+    // Coordinate arrays, of coordType(), each on a 64-byte boundary
+    void* x() const { return static_cast<char*>(base) + sizeof(GraphFileHeader); }
+
+    void* y() const { return static_cast<char*>(base) + header().yOffset; }
+};
+
+// Writes count points of the given type from the arrays xs and ys to path, through a temporary
+// file renamed over it, so readers never see a partial graph. Returns false and sets error
+bool writeGraphFile(const std::string& path, CoordType type, const void* xs, const void* ys, size_t count,
+                    std::string& error);
+
+#endif //GRAPHFILE_HPP
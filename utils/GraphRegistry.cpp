@@ -0,0 +1,27 @@
+#include "GraphRegistry.hpp"
+
+SharedGraph *GraphRegistry::getOrCreate(const std::string &name) {
+    Shard &shard = shardFor(name);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    std::unique_ptr<SharedGraph> &graph = shard.graphs[name];
+    if (!graph) {
+        graph.reset(new SharedGraph());
+    }
+    return graph.get();
+}
+
+SharedGraph *GraphRegistry::find(const std::string &name) {
+    Shard &shard = shardFor(name);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.graphs.find(name);
+    return it == shard.graphs.end() ? nullptr : it->second.get();
+}
+
+size_t GraphRegistry::size() {
+    size_t total = 0;
+    for (Shard &shard: shards) {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        total += shard.graphs.size();
+    }
+    return total;
+}
@@ -0,0 +1,42 @@
+//
+// Named graphs shared by all sessions of a server process.
+//
+
+#ifndef GRAPHREGISTRY_HPP
+#define GRAPHREGISTRY_HPP
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Session.hpp"
+
+// Sharded map from graph name to graph. Lookups lock only the shard the name hashes to,
+// and once found a graph is used under its own lock, so clients on different graphs never
+// contend. Graphs live as long as the registry, so the pointers handed out stay valid.
+class GraphRegistry {
+private:
+    static const size_t SHARDS = 64;
+
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        std::unordered_map<std::string, std::unique_ptr<SharedGraph> > graphs;
+    };
+
+    Shard shards[SHARDS];
+
+    Shard &shardFor(const std::string &name) { return shards[std::hash<std::string>()(name) % SHARDS]; }
+
+public:
+    // Returns the graph called name, creating an empty one on first use
+    SharedGraph *getOrCreate(const std::string &name);
+
+    // Returns the graph called name, or nullptr if it does not exist
+    SharedGraph *find(const std::string &name);
+
+    // Number of named graphs
+    size_t size();
+};
+
+#endif //GRAPHREGISTRY_HPP
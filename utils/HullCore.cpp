@@ -0,0 +1,376 @@
+#include "HullCore.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include "GeometryKernels.hpp"
+#include "RadixSort.hpp"
+
+namespace {
+    template <typename Coord>
+    typename CoordTraits<Coord>::Wide distanceSquared(const BasicPointSpan<Coord>& points, PointIndex a, PointIndex b) {
+        typedef typename CoordTraits<Coord>::Wide Wide;
+        Wide dx = static_cast<typename CoordTraits<Coord>::Diff>(points.x[b]) - points.x[a];
+        Wide dy = static_cast<typename CoordTraits<Coord>::Diff>(points.y[b]) - points.y[a];
+        return dx * dx + dy * dy;
+    }
+
+    template <typename Coord>
+    bool samePoint(const BasicPointSpan<Coord>& points, PointIndex a, PointIndex b) {
+        return points.x[a] == points.x[b] && points.y[a] == points.y[b];
+    }
+
+    std::vector<PointIndex> allIndices(size_t n) {
+        std::vector<PointIndex> idx(n);
+        std::iota(idx.begin(), idx.end(), 0);
+        return idx;
+    }
+
+    // Monotone chain over the points sorted(0), ..., sorted(n - 1) refer to, in (x, y) order.
+    // Writes the hull to out, which needs room for 2 * n indices, and returns its size
+    template <typename Coord, typename Order>
+    size_t chainSorted(const BasicPointSpan<Coord>& points, Order sorted, size_t n, PointIndex* out) {
+        size_t k = 0;
+        // lower chain left to right, then upper chain right to left
+        for (size_t i = 0; i < n; ++i) {
+            while (k >= 2 && orientation(points, out[k - 2], out[k - 1], sorted(i)) <= 0) k--;
+            out[k++] = sorted(i);
+        }
+        for (size_t i = n - 1, lowerSize = k + 1; i > 0; --i) {
+            while (k >= lowerSize && orientation(points, out[k - 2], out[k - 1], sorted(i - 1)) <= 0) k--;
+            out[k++] = sorted(i - 1);
+        }
+        // the last point is the first one again
+        return k > 1 ? k - 1 : k;
+    }
+
+    // Points strictly right of a -> b go to right, points strictly left of it to left
+    template <typename Coord>
+    void splitByLine(const BasicPointSpan<Coord>& points, PointIndex a, PointIndex b, std::vector<PointIndex>& right,
+                     std::vector<PointIndex>& left) {
+        for (size_t i = 0; i < points.size; ++i) {
+            auto cross = orientation(points, a, b, static_cast<PointIndex>(i));
+            if (cross < 0) {
+                right.push_back(static_cast<PointIndex>(i));
+            } else if (cross > 0) {
+                left.push_back(static_cast<PointIndex>(i));
+            }
+        }
+    }
+
+    // The double version runs the vectorized orientBatch kernel first
+    void splitByLine(const PointSpan& points, PointIndex a, PointIndex b, std::vector<PointIndex>& right,
+                     std::vector<PointIndex>& left) {
+        std::vector<double> cross(points.size);
+        orientBatch(points, points.at(a), points.at(b), cross.data());
+        for (size_t i = 0; i < points.size; ++i) {
+            if (cross[i] < 0) {
+                right.push_back(static_cast<PointIndex>(i));
+            } else if (cross[i] > 0) {
+                left.push_back(static_cast<PointIndex>(i));
+            }
+        }
+    }
+
+    PointIndex identity(size_t i) {
+        return static_cast<PointIndex>(i);
+    }
+
+    // Appends the hull vertices strictly right of a -> b, in order from a to b. [first, last)
+    // holds exactly the points strictly right of a -> b and is reordered
+    template <typename Coord>
+    void quickhullSide(const BasicPointSpan<Coord>& points, PointIndex* first, PointIndex* last, PointIndex a, PointIndex b,
+                       std::vector<PointIndex>& hull) {
+        typedef typename CoordTraits<Coord>::Diff Diff;
+        typedef typename CoordTraits<Coord>::Wide Wide;
+        // explicit stack: a segment to split, or a vertex to emit; pushed in reverse so vertices
+        // come out in order from a to b
+        struct Task {
+            PointIndex *first, *last;
+            PointIndex a, b;
+            bool emit;
+        };
+        std::vector<Task> stack;
+        stack.push_back({first, last, a, b, false});
+        while (!stack.empty()) {
+            Task task = stack.back();
+            stack.pop_back();
+            if (task.emit) {
+                hull.push_back(task.a);
+                continue;
+            }
+            if (task.first == task.last) {
+                continue;
+            }
+            // the point farthest right of a -> b is a hull vertex; of several at the same distance
+            // take the one furthest towards b, so the others never end up between two vertices
+            Wide dx = static_cast<Diff>(points.x[task.b]) - points.x[task.a];
+            Wide dy = static_cast<Diff>(points.y[task.b]) - points.y[task.a];
+            PointIndex farthest = *task.first;
+            Wide farthestCross = orientation(points, task.a, task.b, farthest);
+            for (PointIndex *p = task.first + 1; p != task.last; ++p) {
+                Wide cross = orientation(points, task.a, task.b, *p);
+                if (cross < farthestCross ||
+                    (cross == farthestCross &&
+                     dx * (static_cast<Diff>(points.x[*p]) - points.x[farthest]) +
+                     dy * (static_cast<Diff>(points.y[*p]) - points.y[farthest]) > 0)) {
+                    farthest = *p;
+                    farthestCross = cross;
+                }
+            }
+            PointIndex c = farthest;
+            // points right of a -> c, then points right of c -> b; the rest are inside abc
+            PointIndex *mid = std::partition(task.first, task.last, [&](PointIndex p) {
+                return orientation(points, task.a, c, p) < 0;
+            });
+            PointIndex *end = std::partition(mid, task.last, [&](PointIndex p) {
+                return orientation(points, c, task.b, p) < 0;
+            });
+            stack.push_back({mid, end, c, task.b, false});
+            stack.push_back({nullptr, nullptr, c, c, true});
+            stack.push_back({task.first, mid, task.a, c, false});
+        }
+    }
+
+    // Position in hull[0..n) of the vertex that every other vertex is left of or behind, seen
+    // from p. Binary search, then a local walk that settles collinear ties
+    template <typename Coord>
+    size_t tangentIndex(const BasicPointSpan<Coord>& points, const PointIndex* hull, size_t n, PointIndex p) {
+        if (n == 1) {
+            return 0;
+        }
+        // q is a better tangent than the vertex at i if it is right of p -> hull[i], or on that
+        // line and farther away
+        auto better = [&](size_t i, PointIndex q) {
+            auto cross = orientation(points, p, hull[i], q);
+            return cross < 0 ||
+                   (cross == 0 && distanceSquared(points, p, q) > distanceSquared(points, p, hull[i]));
+        };
+        if (n <= 8) {
+            // small group hulls are cheaper to scan than to search
+            size_t best = 0;
+            for (size_t i = 1; i < n; ++i) {
+                if (better(best, hull[i])) best = i;
+            }
+            return best;
+        }
+        auto side = [&](size_t i, size_t j) {
+            auto cross = orientation(points, p, hull[i], hull[j]);
+            return cross > 0 ? 1 : (cross < 0 ? -1 : 0);
+        };
+
+        // binary search for the vertex whose neighbours are both not right of p -> vertex
+        size_t lo = 0, hi = n;
+        int loBefore = side(0, n - 1);
+        int loAfter = side(0, 1);
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            int midBefore = side(mid, (mid + n - 1) % n);
+            int midAfter = side(mid, (mid + 1) % n);
+            int midSide = side(lo, mid);
+            if (midBefore != -1 && midAfter != -1) {
+                lo = mid;
+                break;
+            }
+            if ((midSide == 1 && (loAfter == -1 || loBefore == loAfter)) || (midSide == -1 && midBefore == -1)) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+            if (lo >= n) {
+                lo = 0;
+                break;
+            }
+            loBefore = side(lo, (lo + n - 1) % n);
+            loAfter = side(lo, (lo + 1) % n);
+        }
+
+        // the search lands on or next to the tangent; collinear and repeated vertices need the walk
+        size_t i = lo % n;
+        for (size_t steps = 0; steps < n && better(i, hull[(i + n - 1) % n]); ++steps) {
+            i = (i + n - 1) % n;
+        }
+        for (size_t steps = 0; steps < n && better(i, hull[(i + 1) % n]); ++steps) {
+            i = (i + 1) % n;
+        }
+        return i;
+    }
+
+    // One Chan round with group size m over the points in candidates. Returns false if the hull
+    // has more than m vertices, and then leaves in candidates only the vertices of the group hulls
+    template <typename Coord>
+    bool chanRound(const BasicPointSpan<Coord>& points, std::vector<PointIndex>& candidates, size_t m,
+                   std::vector<PointIndex>& hull) {
+        size_t n = candidates.size();
+        // hulls of all groups back to back: group g is hulls[offsets[g], offsets[g + 1])
+        std::vector<PointIndex> hulls(n + 1);
+        std::vector<size_t> offsets(1, 0);
+        std::vector<PointIndex> members;
+        std::vector<PointIndex> chain(2 * m);
+        for (size_t start = 0; start < n; start += m) {
+            members.assign(candidates.begin() + start, candidates.begin() + std::min(n, start + m));
+            radixSortIndicesByXY(points, members.data(), members.size());
+            size_t k = chainSorted(points, [&members](size_t i) { return members[i]; }, members.size(),
+                                   chain.data());
+            std::copy(chain.begin(), chain.begin() + k, hulls.begin() + offsets.back());
+            offsets.push_back(offsets.back() + k);
+        }
+        size_t groups = offsets.size() - 1;
+
+        // the leftmost (then lowest) point is a hull vertex to start the march from
+        size_t start = 0;
+        for (size_t i = 1; i < offsets.back(); ++i) {
+            PointIndex q = hulls[i], s = hulls[start];
+            if (points.x[q] < points.x[s] || (points.x[q] == points.x[s] && points.y[q] < points.y[s])) {
+                start = i;
+            }
+        }
+        size_t group = std::upper_bound(offsets.begin(), offsets.end(), start) - offsets.begin() - 1;
+
+        hull.clear();
+        size_t current = start;
+        for (size_t step = 0; step < m; ++step) {
+            PointIndex p = hulls[current];
+            hull.push_back(p);
+            // the successor on the own group's hull, then the tangent to every other group
+            size_t size = offsets[group + 1] - offsets[group];
+            size_t successor = offsets[group] + (current - offsets[group] + 1) % size;
+            size_t best = successor, bestGroup = group;
+            for (size_t g = 0; g < groups; ++g) {
+                size_t i = g == group ? successor
+                                      : offsets[g] + tangentIndex(points, &hulls[offsets[g]],
+                                                                  offsets[g + 1] - offsets[g], p);
+                auto cross = orientation(points, p, hulls[best], hulls[i]);
+                bool bestIsP = samePoint(points, hulls[best], p);
+                if (bestIsP || cross < 0 ||
+                    (cross == 0 && distanceSquared(points, p, hulls[i]) > distanceSquared(points, p, hulls[best]))) {
+                    best = i;
+                    bestGroup = g;
+                }
+            }
+            if (samePoint(points, hulls[best], hulls[start])) {
+                return true;
+            }
+            if (samePoint(points, hulls[best], p)) {
+                return true; // every point is the same point
+            }
+            current = best;
+            group = bestGroup;
+        }
+        // only group hull vertices can be hull vertices, so the next round starts from those
+        hulls.resize(offsets.back());
+        candidates.swap(hulls);
+        return false;
+    }
+}
+
+template <typename Coord>
+std::vector<PointIndex> grahamScanIndices(const BasicPointSpan<Coord>& points) {
+    size_t n = points.size;
+    std::vector<PointIndex> idx = allIndices(n);
+    if (n <= 2) return idx; // Handle edge cases
+
+    // Make the lowest point (and if tied, the leftmost) the first point
+    std::swap(idx[0], idx[lowestPointIndex(points)]);
+
+    // Sort points by polar angle with respect to the lowest point
+    PointIndex pivot = idx[0];
+    std::sort(idx.begin() + 1, idx.end(), [&points, pivot](PointIndex p1, PointIndex p2) {
+        auto cross = orientation(points, pivot, p1, p2);
+        if (CoordTraits<Coord>::collinear(cross)) {
+            // If collinear, sort by distance from pivot
+            return distanceSquared(points, pivot, p1) < distanceSquared(points, pivot, p2);
+        }
+        return cross > 0; // Counter-clockwise orientation
+    });
+
+    // Construct the convex hull using a stack
+    std::vector<PointIndex> hull;
+    hull.push_back(idx[0]);
+    hull.push_back(idx[1]);
+    for (size_t i = 2; i < n; ++i) {
+        while (hull.size() > 1 && orientation(points, hull[hull.size() - 2], hull.back(), idx[i]) <= 0) {
+            hull.pop_back();
+        }
+        hull.push_back(idx[i]);
+    }
+    return hull;
+}
+
+template <typename Coord>
+std::vector<PointIndex> monotoneChainIndices(const BasicPointSpan<Coord>& points, bool sorted) {
+    size_t n = points.size;
+    if (n <= 2) return allIndices(n);
+
+    std::vector<PointIndex> hull(2 * n);
+    if (sorted) {
+        hull.resize(chainSorted(points, identity, n, hull.data()));
+        return hull;
+    }
+    // (x, y) order needs no orientation tests, so radix sort instead of a comparison sort
+    std::vector<PointIndex> idx = allIndices(n);
+    radixSortIndicesByXY(points, idx.data(), n);
+    // the chain walks the points in sorted order, so copy them into that order first: one pass
+    // of independent loads costs less than a cache miss on every step of the chain
+    BasicPointStore<Coord> ordered;
+    ordered.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        ordered.push_back(points.x[idx[i]], points.y[idx[i]]);
+    }
+    hull.resize(chainSorted(ordered.span(), identity, n, hull.data()));
+    for (PointIndex& i: hull) {
+        i = idx[i];
+    }
+    return hull;
+}
+
+template <typename Coord>
+std::vector<PointIndex> quickhullIndices(const BasicPointSpan<Coord>& points) {
+    size_t n = points.size;
+    if (n <= 2) return allIndices(n);
+
+    // leftmost-lowest and rightmost-highest points split the hull into its lower and upper part
+    size_t left, right;
+    extremeXIndices(points, left, right);
+
+    std::vector<PointIndex> hull;
+    hull.push_back(static_cast<PointIndex>(left));
+    if (samePoint(points, left, right)) {
+        return hull; // every point is the same point
+    }
+    // below the line from left to right, and above it
+    std::vector<PointIndex> below, above;
+    splitByLine(points, left, right, below, above);
+    quickhullSide(points, below.data(), below.data() + below.size(), left, right, hull);
+    hull.push_back(static_cast<PointIndex>(right));
+    quickhullSide(points, above.data(), above.data() + above.size(), right, left, hull);
+    return hull;
+}
+
+template <typename Coord>
+std::vector<PointIndex> chanIndices(const BasicPointSpan<Coord>& points) {
+    size_t n = points.size;
+    std::vector<PointIndex> candidates = allIndices(n);
+    if (n <= 2) return candidates;
+
+    std::vector<PointIndex> hull;
+    // group sizes 16, 256, 65536, ... until one round closes the hull; groups of 4 cull too
+    // little to pay for their round
+    for (unsigned t = 2;; ++t) {
+        n = candidates.size();
+        size_t m = t >= 6 ? n : std::min(n, static_cast<size_t>(1) << (1u << t));
+        if (chanRound(points, candidates, m, hull) || m == n) {
+            return hull;
+        }
+    }
+}
+
+#define HULL_CORE_INSTANTIATE(Coord) \
+    template std::vector<PointIndex> grahamScanIndices(const BasicPointSpan<Coord>&); \
+    template std::vector<PointIndex> monotoneChainIndices(const BasicPointSpan<Coord>&, bool); \
+    template std::vector<PointIndex> quickhullIndices(const BasicPointSpan<Coord>&); \
+    template std::vector<PointIndex> chanIndices(const BasicPointSpan<Coord>&);
+
+HULL_CORE_INSTANTIATE(double)
+HULL_CORE_INSTANTIATE(float)
+HULL_CORE_INSTANTIATE(int32_t)
+HULL_CORE_INSTANTIATE(int64_t)
@@ -0,0 +1,43 @@
+//
+// Hull engines over structure-of-arrays points.
+//
+
+#ifndef HULLCORE_HPP
+#define HULLCORE_HPP
+
+#include <vector>
+#include "PointStore.hpp"
+
+// Every engine orders an index array over the span instead of moving points, and returns the
+// hull as indices into the span in counter-clockwise order. The engines are instantiated for the
+// coordinate types of CoordType in HullCore.cpp.
+
+// Cross product of a->b and a->c, positive when c is left of a -> b. Taken in
+// CoordTraits<Coord>::Wide, so it is exact for the integer coordinate types
+template <typename Coord>
+typename CoordTraits<Coord>::Wide orientation(const BasicPointSpan<Coord>& points, PointIndex a, PointIndex b,
+                                              PointIndex c) {
+    typedef typename CoordTraits<Coord>::Diff Diff;
+    typedef typename CoordTraits<Coord>::Wide Wide;
+    Diff abx = static_cast<Diff>(points.x[b]) - points.x[a], aby = static_cast<Diff>(points.y[b]) - points.y[a];
+    Diff acx = static_cast<Diff>(points.x[c]) - points.x[a], acy = static_cast<Diff>(points.y[c]) - points.y[a];
+    return static_cast<Wide>(abx) * acy - static_cast<Wide>(aby) * acx;
+}
+
+// Graham scan from the lowest point; angle ties within CoordTraits<Coord>::collinear go by distance
+template <typename Coord>
+std::vector<PointIndex> grahamScanIndices(const BasicPointSpan<Coord>& points);
+
+// Andrew's monotone chain over a radix sort by (x, y); sorted skips the sort
+template <typename Coord>
+std::vector<PointIndex> monotoneChainIndices(const BasicPointSpan<Coord>& points, bool sorted = false);
+
+// Quickhull by farthest-point partitioning, with an explicit stack
+template <typename Coord>
+std::vector<PointIndex> quickhullIndices(const BasicPointSpan<Coord>& points);
+
+// Chan's algorithm, O(n log h) for h hull vertices
+template <typename Coord>
+std::vector<PointIndex> chanIndices(const BasicPointSpan<Coord>& points);
+
+#endif //HULLCORE_HPP
@@ -0,0 +1,195 @@
+#include "HullPrefilter.hpp"
+
+#include "GeometryKernels.hpp"
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HULL_PREFILTER_X86 1
+#endif
+
+namespace {
+    // Edges of the octagon as (a, b - a), so the test is the same cross product as orientation
+    template <typename Coord>
+    struct Octagon {
+        typedef typename CoordTraits<Coord>::Diff Diff;
+        Diff ax[8], ay[8], ex[8], ey[8];
+        int edges;
+    };
+
+    // Builds the octagon from the extreme points in counter-clockwise order. Returns false when
+    // the extremes span less than a triangle and nothing can be culled.
+    template <typename Coord>
+    bool buildOctagon(const BasicPointSpan<Coord>& points, Octagon<Coord>& oct) {
+        typedef typename CoordTraits<Coord>::Diff Diff;
+        const Coord* x = points.x;
+        const Coord* y = points.y;
+        auto sum = [x, y](size_t i) { return static_cast<Diff>(x[i]) + y[i]; };
+        auto difference = [x, y](size_t i) { return static_cast<Diff>(x[i]) - y[i]; };
+        // minY, max(x-y), maxX, max(x+y), maxY, min(x-y), minX, min(x+y)
+        size_t ext[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        for (size_t i = 1; i < points.size; ++i) {
+            if (y[i] < y[ext[0]]) ext[0] = i;
+            if (difference(i) > difference(ext[1])) ext[1] = i;
+            if (x[i] > x[ext[2]]) ext[2] = i;
+            if (sum(i) > sum(ext[3])) ext[3] = i;
+            if (y[i] > y[ext[4]]) ext[4] = i;
+            if (difference(i) < difference(ext[5])) ext[5] = i;
+            if (x[i] < x[ext[6]]) ext[6] = i;
+            if (sum(i) < sum(ext[7])) ext[7] = i;
+        }
+        oct.edges = 0;
+        for (int i = 0; i < 8; ++i) {
+            size_t a = ext[i];
+            size_t b = ext[(i + 1) % 8];
+            if (x[a] == x[b] && y[a] == y[b]) {
+                continue; // the same point is extreme in both directions
+            }
+            oct.ax[oct.edges] = x[a];
+            oct.ay[oct.edges] = y[a];
+            oct.ex[oct.edges] = static_cast<Diff>(x[b]) - x[a];
+            oct.ey[oct.edges] = static_cast<Diff>(y[b]) - y[a];
+            oct.edges++;
+        }
+        return oct.edges >= 3;
+    }
+
+    // Exact for the integer types: every product is taken in CoordTraits<Coord>::Wide
+    template <typename Coord>
+    bool insideScalar(const Octagon<Coord>& oct, Coord x, Coord y) {
+        typedef typename CoordTraits<Coord>::Diff Diff;
+        typedef typename CoordTraits<Coord>::Wide Wide;
+        for (int e = 0; e < oct.edges; ++e) {
+            if (static_cast<Wide>(oct.ex[e]) * (static_cast<Diff>(y) - oct.ay[e]) -
+                static_cast<Wide>(oct.ey[e]) * (static_cast<Diff>(x) - oct.ax[e]) <= 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#if defined(HULL_PREFILTER_X86)
+    __attribute__((target("avx2")))
+    inline __m256d load4(const double* p) {
+        return _mm256_loadu_pd(p);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256d load4(const float* p) {
+        return _mm256_cvtps_pd(_mm_loadu_ps(p));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256d load4(const int32_t* p) {
+        return _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+
+    // Four points per step, in double. Drops only points more than margin inside every edge.
+    // Returns how many points it tested
+    template <typename Coord>
+    __attribute__((target("avx2")))
+    size_t filterAvx2(const Octagon<double>& oct, const BasicPointSpan<Coord>& points, double margin,
+                      std::vector<PointIndex>& kept) {
+        size_t i = 0;
+        for (; i + 4 <= points.size; i += 4) {
+            __m256d xs = load4(points.x + i);
+            __m256d ys = load4(points.y + i);
+            __m256d inside = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            for (int e = 0; e < oct.edges; ++e) {
+                __m256d cross = _mm256_sub_pd(
+                    _mm256_mul_pd(_mm256_set1_pd(oct.ex[e]), _mm256_sub_pd(ys, _mm256_set1_pd(oct.ay[e]))),
+                    _mm256_mul_pd(_mm256_set1_pd(oct.ey[e]), _mm256_sub_pd(xs, _mm256_set1_pd(oct.ax[e]))));
+                inside = _mm256_and_pd(inside, _mm256_cmp_pd(cross, _mm256_set1_pd(margin), _CMP_GT_OQ));
+            }
+            int mask = _mm256_movemask_pd(inside);
+            if (mask == 0xf) {
+                continue;
+            }
+            for (int lane = 0; lane < 4; ++lane) {
+                if (!(mask & (1 << lane))) {
+                    kept.push_back(static_cast<PointIndex>(i + lane));
+                }
+            }
+        }
+        return i;
+    }
+#endif
+
+#if defined(__SSE2__)
+    // Two points per step, the x86-64 baseline. Returns how many points it tested
+    size_t filterSse2(const Octagon<double>& oct, const PointSpan& points, std::vector<PointIndex>& kept) {
+        size_t i = 0;
+        for (; i + 2 <= points.size; i += 2) {
+            __m128d xs = _mm_loadu_pd(points.x + i);
+            __m128d ys = _mm_loadu_pd(points.y + i);
+            __m128d inside = _mm_castsi128_pd(_mm_set1_epi64x(-1));
+            for (int e = 0; e < oct.edges; ++e) {
+                __m128d cross = _mm_sub_pd(
+                    _mm_mul_pd(_mm_set1_pd(oct.ex[e]), _mm_sub_pd(ys, _mm_set1_pd(oct.ay[e]))),
+                    _mm_mul_pd(_mm_set1_pd(oct.ey[e]), _mm_sub_pd(xs, _mm_set1_pd(oct.ax[e]))));
+                inside = _mm_and_pd(inside, _mm_cmpgt_pd(cross, _mm_setzero_pd()));
+            }
+            int mask = _mm_movemask_pd(inside);
+            if (mask == 0x3) {
+                continue;
+            }
+            for (int lane = 0; lane < 2; ++lane) {
+                if (!(mask & (1 << lane))) {
+                    kept.push_back(static_cast<PointIndex>(i + lane));
+                }
+            }
+        }
+        return i;
+    }
+#endif
+}
+
+template <typename Coord>
+size_t aklToussaintFilter(const BasicPointSpan<Coord>& points, std::vector<PointIndex>& kept) {
+    kept.clear();
+    Octagon<Coord> oct;
+    if (points.size < 9 || !buildOctagon(points, oct)) {
+        for (size_t i = 0; i < points.size; ++i) {
+            kept.push_back(static_cast<PointIndex>(i));
+        }
+        return 0;
+    }
+
+    size_t i = 0;
+#if defined(HULL_PREFILTER_X86)
+    // int32 coordinates and their differences are exact in double, and the products round by
+    // at most 2^62 * 2^-53 each, so a margin of 4096 keeps every point the exact test keeps.
+    // int64 coordinates do not fit in double and always take the exact scalar test
+    if constexpr (!std::is_same<Coord, int64_t>::value) {
+        if (cpuHasAvx2()) {
+            Octagon<double> wide;
+            wide.edges = oct.edges;
+            for (int e = 0; e < oct.edges; ++e) {
+                wide.ax[e] = static_cast<double>(oct.ax[e]);
+                wide.ay[e] = static_cast<double>(oct.ay[e]);
+                wide.ex[e] = static_cast<double>(oct.ex[e]);
+                wide.ey[e] = static_cast<double>(oct.ey[e]);
+            }
+            i = filterAvx2(wide, points, std::is_same<Coord, int32_t>::value ? 4096.0 : 0.0, kept);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    if constexpr (std::is_same<Coord, double>::value) {
+        if (i == 0) {
+            i = filterSse2(oct, points, kept);
+        }
+    }
+#endif
+    for (; i < points.size; ++i) {
+        if (!insideScalar(oct, points.x[i], points.y[i])) {
+            kept.push_back(static_cast<PointIndex>(i));
+        }
+    }
+    return points.size - kept.size();
+}
+
+template size_t aklToussaintFilter(const BasicPointSpan<double>&, std::vector<PointIndex>&);
+template size_t aklToussaintFilter(const BasicPointSpan<float>&, std::vector<PointIndex>&);
+template size_t aklToussaintFilter(const BasicPointSpan<int32_t>&, std::vector<PointIndex>&);
+template size_t aklToussaintFilter(const BasicPointSpan<int64_t>&, std::vector<PointIndex>&);
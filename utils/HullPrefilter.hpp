@@ -0,0 +1,20 @@
+//
+// Akl-Toussaint interior point elimination in front of the hull engines.
+//
+
+#ifndef HULLPREFILTER_HPP
+#define HULLPREFILTER_HPP
+
+#include <cstddef>
+#include <vector>
+#include "PointStore.hpp"
+
+// Stores in kept the index of every point not strictly inside the octagon spanned by the extreme
+// points in x, y, x+y and x-y, and returns how many were dropped. Those points cannot be hull
+// vertices, so any engine run on the kept points gives the same hull. The inside test uses AVX2
+// when the CPU has it (in double, with a safety margin for int32), SSE2 for double coordinates on
+// other x86-64 CPUs, and otherwise a scalar loop that is exact for the integer types.
+template <typename Coord>
+size_t aklToussaintFilter(const BasicPointSpan<Coord>& points, std::vector<PointIndex>& kept);
+
+#endif //HULLPREFILTER_HPP
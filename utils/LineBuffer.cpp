@@ -0,0 +1,69 @@
+#include "LineBuffer.hpp"
+#include <algorithm>
+#include <cstring>
+
+LineBuffer::LineBuffer(size_t maxLine)
+    : begin(0), end(0), scanned(0), maxLine(maxLine), skipping(false), overflows(0) {
+}
+
+char *LineBuffer::prepare(size_t minSpace) {
+    if (begin == end) {
+        begin = end = 0;
+    }
+    if (space() < minSpace) {
+        compact();
+    }
+    if (space() < minSpace) {
+        data.resize(std::max(2 * data.size(), end + minSpace));
+    }
+    return data.data() + end;
+}
+
+void LineBuffer::compact() {
+    if (begin > 0) {
+        std::memmove(data.data(), data.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+}
+
+bool LineBuffer::nextLine(std::string_view &line) {
+    while (begin < end) {
+        const char *start = data.data() + begin;
+        const void *newline = std::memchr(start + scanned, '\n', end - begin - scanned);
+        if (newline == nullptr) {
+            scanned = end - begin;
+            if (skipping) {
+                begin = end;
+                scanned = 0;
+            } else if (scanned > maxLine) {
+                // the line is not kept, whatever else of it arrives
+                begin = end;
+                scanned = 0;
+                skipping = true;
+                overflows++;
+            }
+            return false;
+        }
+        size_t length = static_cast<size_t>(static_cast<const char *>(newline) - start);
+        begin += length + 1;
+        scanned = 0;
+        if (skipping) {
+            skipping = false;
+            continue;
+        }
+        if (length > maxLine) {
+            overflows++;
+            continue;
+        }
+        line = std::string_view(start, length);
+        return true;
+    }
+    return false;
+}
+
+size_t LineBuffer::takeOverflows() {
+    size_t dropped = overflows;
+    overflows = 0;
+    return dropped;
+}
@@ -0,0 +1,60 @@
+//
+// Per-connection input buffer: bytes are received straight into it and taken out again as
+// complete newline-terminated lines, however the stream was split into reads.
+//
+
+#ifndef LINEBUFFER_HPP
+#define LINEBUFFER_HPP
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+class LineBuffer {
+private:
+    std::vector<char> data;
+    size_t begin;     // first byte not taken out yet
+    size_t end;       // one past the last byte received
+    size_t scanned;   // bytes from begin known to hold no newline, so each byte is searched once
+    size_t maxLine;   // longest line kept; longer ones are dropped
+    bool skipping;    // dropping the rest of an over-long line, up to its newline
+    size_t overflows; // lines dropped since takeOverflows
+
+public:
+    explicit LineBuffer(size_t maxLine = 1 << 16);
+
+    // Room for at least minSpace more bytes after the received ones, found by first moving the
+    // unread bytes to the front and then growing. Invalidates the lines taken out so far
+    char* prepare(size_t minSpace);
+
+    // Bytes that fit after the received ones
+    size_t space() const { return data.size() - end; }
+
+    // Marks n bytes written at prepare() as received
+    void commit(size_t n) { end += n; }
+
+    // Takes out the next complete line, without its '\n'. It stays valid until the next prepare.
+    // Returns false if no complete line is buffered
+    bool nextLine(std::string_view& line);
+
+    // Unread bytes, the start of an incomplete line
+    size_t size() const { return end - begin; }
+
+    // The unread bytes themselves, for input that is not framed in lines. Valid until the next
+    // prepare or compact
+    std::string_view unread() const { return std::string_view(data.data() + begin, end - begin); }
+
+    // Takes out the first n unread bytes
+    void consume(size_t n) {
+        begin += n;
+        scanned = 0;
+    }
+
+    // Moves the unread bytes to the front of the buffer, which is aligned for any type
+    void compact();
+
+    // Number of lines longer than maxLine dropped since the last call
+    size_t takeOverflows();
+};
+
+#endif //LINEBUFFER_HPP
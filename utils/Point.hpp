@@ -0,0 +1,17 @@
+#ifndef POINT_HPP
+#define POINT_HPP
+
+#include <cmath>
+
+// Point structure needed by the ConvexHullCalculator
+struct Point {
+    double x, y;
+
+    Point(double _x = 0, double _y = 0) : x(_x), y(_y) {}
+
+    bool operator==(const Point& other) const {
+        return (fabs(x - other.x) < 1e-9 && fabs(y - other.y) < 1e-9);
+    }
+};
+
+#endif //POINT_HPP
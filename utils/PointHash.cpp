@@ -0,0 +1,438 @@
+#include "PointHash.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+    // Cells of double coordinates: 4 epsilons wide, so two values within the epsilon of each
+    // other land in the same or adjacent cells even after the division rounds
+    const double CELL = 4e-9;
+
+    uint64_t bitsOf(double d) {
+        d += 0.0; // -0.0 and 0.0 are the same cell
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof bits);
+        return bits;
+    }
+
+    double cellOf(double v) {
+        return std::floor(v / CELL);
+    }
+
+    // Key of a coordinate the other types match exactly
+    uint64_t keyOf(float f) {
+        f += 0.0f;
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof bits);
+        return bits;
+    }
+
+    uint64_t keyOf(int32_t i) {
+        return static_cast<uint32_t>(i);
+    }
+
+    uint64_t keyOf(int64_t i) {
+        return static_cast<uint64_t>(i);
+    }
+
+    uint64_t mix(uint64_t a, uint64_t b) {
+        uint64_t h = a * 0x9E3779B97F4A7C15ull ^ (b + 0x632BE59BD9B4E019ull);
+        h ^= h >> 31;
+        h *= 0xBF58476D1CE4E5B9ull;
+        return h ^ (h >> 29);
+    }
+}
+
+void BucketChains::reset(size_t buckets, size_t capacity) {
+    heads.assign(buckets, NONE);
+    next.resize(capacity);
+    prev.resize(capacity);
+}
+
+void BucketChains::clear() {
+    heads.clear();
+    next.clear();
+    prev.clear();
+}
+
+void BucketChains::link(PointIndex i, size_t bucket) {
+    prev[i] = NONE;
+    next[i] = heads[bucket];
+    if (next[i] != NONE) {
+        prev[next[i]] = i;
+    }
+    heads[bucket] = i;
+}
+
+void BucketChains::unlink(PointIndex i, size_t bucket) {
+    if (prev[i] != NONE) {
+        next[prev[i]] = next[i];
+    } else {
+        heads[bucket] = next[i];
+    }
+    if (next[i] != NONE) {
+        prev[next[i]] = prev[i];
+    }
+}
+
+void BucketChains::relabel(PointIndex from, PointIndex to, size_t bucket) {
+    next[to] = next[from];
+    prev[to] = prev[from];
+    if (prev[to] != NONE) {
+        next[prev[to]] = to;
+    } else {
+        heads[bucket] = to;
+    }
+    if (next[to] != NONE) {
+        prev[next[to]] = to;
+    }
+}
+
+template <typename Coord>
+size_t PointHash<Coord>::bucketOf(uint64_t cellX, uint64_t cellY) const {
+    return mix(cellX, cellY) & (chains.buckets() - 1);
+}
+
+template <typename Coord>
+size_t PointHash<Coord>::bucketOf(Coord x, Coord y) const {
+    if constexpr (std::is_same<Coord, double>::value) {
+        return bucketOf(bitsOf(cellOf(x)), bitsOf(cellOf(y)));
+    } else {
+        return bucketOf(keyOf(x), keyOf(y));
+    }
+}
+
+template <typename Coord>
+void PointHash<Coord>::rehash(const BasicPointSpan<Coord>& points, size_t capacity) {
+    // at most one point per two buckets on average
+    size_t buckets = 16;
+    while (buckets < 2 * capacity) {
+        buckets *= 2;
+    }
+    chains.reset(buckets, capacity);
+    for (size_t i = 0; i < points.size; ++i) {
+        chains.link(static_cast<PointIndex>(i), bucketOf(points.x[i], points.y[i]));
+    }
+}
+
+template <typename Coord>
+void PointHash<Coord>::assign(const BasicPointSpan<Coord>& points) {
+    rehash(points, std::max<size_t>(points.size, 16));
+}
+
+template <typename Coord>
+void PointHash<Coord>::insert(const BasicPointSpan<Coord>& points, PointIndex i) {
+    if (i >= chains.capacity()) {
+        // doubling keeps inserts O(1) amortized, like the store itself
+        rehash(points, std::max(2 * chains.capacity(), points.size));
+        return;
+    }
+    chains.link(i, bucketOf(points.x[i], points.y[i]));
+}
+
+template <typename Coord>
+size_t PointHash<Coord>::find(const BasicPointSpan<Coord>& points, Coord x, Coord y) const {
+    if (chains.empty()) {
+        return points.size;
+    }
+    auto search = [&](size_t bucket) {
+        for (PointIndex i = chains.head(bucket); i != BucketChains::NONE; i = chains.after(i)) {
+            if (CoordTraits<Coord>::equal(points.x[i], x) && CoordTraits<Coord>::equal(points.y[i], y)) {
+                return static_cast<size_t>(i);
+            }
+        }
+        return points.size;
+    };
+    if constexpr (std::is_same<Coord, double>::value) {
+        // a match within the epsilon may sit in any cell next to the query's; exact repeats are
+        // the common case and always in the query's own cell, so it goes first
+        double cellX = cellOf(x), cellY = cellOf(y);
+        size_t found = search(bucketOf(bitsOf(cellX), bitsOf(cellY)));
+        for (double dx = -1; dx <= 1 && found == points.size; ++dx) {
+            for (double dy = -1; dy <= 1 && found == points.size; ++dy) {
+                if (dx != 0 || dy != 0) {
+                    found = search(bucketOf(bitsOf(cellX + dx), bitsOf(cellY + dy)));
+                }
+            }
+        }
+        return found;
+    } else {
+        return search(bucketOf(x, y));
+    }
+}
+
+template <typename Coord>
+void PointHash<Coord>::erase(const BasicPointSpan<Coord>& points, PointIndex i) {
+    chains.unlink(i, bucketOf(points.x[i], points.y[i]));
+}
+
+template <typename Coord>
+void PointHash<Coord>::relabel(const BasicPointSpan<Coord>& points, PointIndex from, PointIndex to) {
+    chains.relabel(from, to, bucketOf(points.x[from], points.y[from]));
+}
+
+namespace {
+    // Cell of offset t in cells from the grid origin, clamped to [0, cells). Monotone in t, so a
+    // coordinate range maps onto a contiguous range of cells
+    size_t clampCell(double t, size_t cells) {
+        if (!(t >= 0)) {
+            return 0; // also NaN
+        }
+        if (t >= static_cast<double>(cells)) {
+            return cells - 1;
+        }
+        return static_cast<size_t>(t);
+    }
+}
+
+template <typename Coord>
+size_t PointGrid<Coord>::columnOf(Coord x) const {
+    return clampCell((static_cast<double>(x) - originX) * columnsPerUnit, columns);
+}
+
+template <typename Coord>
+size_t PointGrid<Coord>::rowOf(Coord y) const {
+    return clampCell((static_cast<double>(y) - originY) * rowsPerUnit, rows);
+}
+
+template <typename Coord>
+void PointGrid<Coord>::rebuild(const BasicPointSpan<Coord>& points, size_t capacity) {
+    double minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for (size_t i = 0; i < points.size; ++i) {
+        double x = static_cast<double>(points.x[i]), y = static_cast<double>(points.y[i]);
+        if (i == 0 || x < minX) minX = x;
+        if (i == 0 || x > maxX) maxX = x;
+        if (i == 0 || y < minY) minY = y;
+        if (i == 0 || y > maxY) maxY = y;
+    }
+    originX = minX;
+    originY = minY;
+    double width = maxX - minX, height = maxY - minY;
+
+    // about two points per cell, split between the axes by the aspect ratio of the box
+    size_t cells = std::max<size_t>(1, capacity / 2);
+    if (!(width > 0) && !(height > 0)) {
+        columns = rows = 1;
+    } else if (!(width > 0)) {
+        columns = 1;
+        rows = cells;
+    } else if (!(height > 0)) {
+        columns = cells;
+        rows = 1;
+    } else {
+        double ratio = std::sqrt(static_cast<double>(cells) * width / height);
+        columns = std::min(cells, std::max<size_t>(1, static_cast<size_t>(ratio)));
+        rows = std::max<size_t>(1, cells / columns);
+    }
+    columnsPerUnit = width > 0 && std::isfinite(width) ? columns / width : 0;
+    rowsPerUnit = height > 0 && std::isfinite(height) ? rows / height : 0;
+
+    chains.reset(columns * rows, capacity);
+    for (size_t i = 0; i < points.size; ++i) {
+        chains.link(static_cast<PointIndex>(i), cellOf(points.x[i], points.y[i]));
+    }
+}
+
+template <typename Coord>
+void PointGrid<Coord>::assign(const BasicPointSpan<Coord>& points) {
+    rebuild(points, std::max<size_t>(points.size, 16));
+}
+
+template <typename Coord>
+void PointGrid<Coord>::insert(const BasicPointSpan<Coord>& points, PointIndex i) {
+    if (i >= chains.capacity()) {
+        // the rebuild also refits the grid to points added outside it
+        rebuild(points, std::max(2 * chains.capacity(), points.size));
+        return;
+    }
+    chains.link(i, cellOf(points.x[i], points.y[i]));
+}
+
+template <typename Coord>
+void PointGrid<Coord>::findInRect(const BasicPointSpan<Coord>& points, Coord minX, Coord minY, Coord maxX,
+                                  Coord maxY, std::vector<PointIndex>& out) const {
+    if (chains.empty() || minX > maxX || minY > maxY) {
+        return;
+    }
+    size_t firstColumn = columnOf(minX), lastColumn = columnOf(maxX);
+    size_t lastRow = rowOf(maxY);
+    for (size_t row = rowOf(minY); row <= lastRow; ++row) {
+        for (size_t column = firstColumn; column <= lastColumn; ++column) {
+            for (PointIndex i = chains.head(row * columns + column); i != BucketChains::NONE; i = chains.after(i)) {
+                if (points.x[i] >= minX && points.x[i] <= maxX && points.y[i] >= minY && points.y[i] <= maxY) {
+                    out.push_back(i);
+                }
+            }
+        }
+    }
+}
+
+template <typename Coord>
+void PointGrid<Coord>::erase(const BasicPointSpan<Coord>& points, PointIndex i) {
+    chains.unlink(i, cellOf(points.x[i], points.y[i]));
+}
+
+template <typename Coord>
+void PointGrid<Coord>::relabel(const BasicPointSpan<Coord>& points, PointIndex from, PointIndex to) {
+    chains.relabel(from, to, cellOf(points.x[from], points.y[from]));
+}
+
+template <typename Coord>
+void IndexedPointStore<Coord>::clear() {
+    store.clear();
+    hash.clear();
+    grid.clear();
+    hashed = gridded = false;
+    counts.clear();
+    totalPoints = 0;
+}
+
+template <typename Coord>
+void IndexedPointStore<Coord>::resize(size_t n) {
+    // under dedup the n origins are one point
+    store.resize(dedup ? std::min<size_t>(n, 1) : n);
+    hash.clear();
+    grid.clear();
+    hashed = gridded = false;
+    counts.assign(dedup ? store.size() : 0, static_cast<uint32_t>(n));
+    totalPoints = n;
+}
+
+template <typename Coord>
+void IndexedPointStore<Coord>::assign(const Coord* x, const Coord* y, size_t n) {
+    clear();
+    if (dedup) {
+        for (size_t i = 0; i < n; ++i) {
+            push_back(x[i], y[i]);
+        }
+        return;
+    }
+    store.assign(x, y, n);
+    totalPoints = n;
+}
+
+template <typename Coord>
+void IndexedPointStore<Coord>::adopt(Coord* x, Coord* y, size_t n, std::shared_ptr<void> owner) {
+    if (dedup) {
+        assign(x, y, n);
+        return;
+    }
+    clear();
+    store.adopt(x, y, n, std::move(owner));
+    totalPoints = n;
+}
+
+template <typename Coord>
+void IndexedPointStore<Coord>::setDedup(bool enabled) {
+    if (enabled == dedup) {
+        return;
+    }
+    BasicPointStore<Coord> old = store;
+    std::vector<uint32_t> oldCounts;
+    oldCounts.swap(counts);
+    clear();
+    dedup = enabled;
+    for (size_t i = 0; i < old.size(); ++i) {
+        for (uint32_t copy = 0; copy < (oldCounts.empty() ? 1 : oldCounts[i]); ++copy) {
+            push_back(old.x()[i], old.y()[i]);
+        }
+    }
+}
+
+template <typename Coord>
+void IndexedPointStore<Coord>::append(Coord x, Coord y, uint32_t count) {
+    store.push_back(x, y);
+    PointIndex added = static_cast<PointIndex>(store.size() - 1);
+    if (hashed) {
+        hash.insert(store.span(), added);
+    }
+    if (gridded) {
+        grid.insert(store.span(), added);
+    }
+    if (dedup) {
+        counts.push_back(count);
+    }
+}
+
+template <typename Coord>
+size_t IndexedPointStore<Coord>::push_back(Coord x, Coord y) {
+    totalPoints++;
+    if (dedup) {
+        size_t i = find(x, y);
+        if (i != store.size()) {
+            counts[i]++;
+            return i;
+        }
+    }
+    append(x, y, 1);
+    return store.size() - 1;
+}
+
+template <typename Coord>
+size_t IndexedPointStore<Coord>::find(Coord x, Coord y) {
+    if (!hashed) {
+        hash.assign(store.span());
+        hashed = true;
+    }
+    return hash.find(store.span(), x, y);
+}
+
+template <typename Coord>
+void IndexedPointStore<Coord>::findInRect(Coord minX, Coord minY, Coord maxX, Coord maxY,
+                                          std::vector<PointIndex>& out) {
+    if (!gridded) {
+        grid.assign(store.span());
+        gridded = true;
+    }
+    grid.findInRect(store.span(), minX, minY, maxX, maxY, out);
+}
+
+template <typename Coord>
+void IndexedPointStore<Coord>::swapRemove(size_t i) {
+    PointIndex removed = static_cast<PointIndex>(i);
+    PointIndex last = static_cast<PointIndex>(store.size() - 1);
+    totalPoints -= multiplicity(i);
+    if (dedup) {
+        counts[i] = counts[last];
+        counts.pop_back();
+    }
+    if (hashed) {
+        hash.erase(store.span(), removed);
+        if (removed != last) {
+            hash.relabel(store.span(), last, removed);
+        }
+    }
+    if (gridded) {
+        grid.erase(store.span(), removed);
+        if (removed != last) {
+            grid.relabel(store.span(), last, removed);
+        }
+    }
+    store.swapRemove(i);
+}
+
+template <typename Coord>
+void IndexedPointStore<Coord>::removeCopy(size_t i) {
+    if (multiplicity(i) > 1) {
+        counts[i]--;
+        totalPoints--;
+        return;
+    }
+    swapRemove(i);
+}
+
+template class PointHash<double>;
+template class PointHash<float>;
+template class PointHash<int32_t>;
+template class PointHash<int64_t>;
+
+template class PointGrid<double>;
+template class PointGrid<float>;
+template class PointGrid<int32_t>;
+template class PointGrid<int64_t>;
+
+template class IndexedPointStore<double>;
+template class IndexedPointStore<float>;
+template class IndexedPointStore<int32_t>;
+template class IndexedPointStore<int64_t>;
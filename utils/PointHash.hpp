@@ -0,0 +1,211 @@
+//
+// Indexes over the points of a PointStore: a hash for lookups by coordinates and a grid for
+// rectangle queries.
+//
+
+#ifndef POINTHASH_HPP
+#define POINTHASH_HPP
+
+#include <cstdint>
+#include <vector>
+#include "PointStore.hpp"
+
+// Points grouped into buckets, chained through per-point links so inserting, erasing and
+// relabeling a point are O(1) whatever the bucket sizes. Callers map coordinates to buckets.
+class BucketChains {
+private:
+    std::vector<PointIndex> heads; // first point of each bucket
+    std::vector<PointIndex> next;  // next point in the same bucket, by position
+    std::vector<PointIndex> prev;  // previous point in the same bucket, NONE for the head
+
+public:
+    static constexpr PointIndex NONE = UINT32_MAX;
+
+    // Empties buckets buckets with room for positions below capacity
+    void reset(size_t buckets, size_t capacity);
+
+    void clear();
+
+    bool empty() const { return heads.empty(); }
+
+    size_t buckets() const { return heads.size(); }
+
+    size_t capacity() const { return next.size(); }
+
+    PointIndex head(size_t bucket) const { return heads[bucket]; }
+
+    PointIndex after(PointIndex i) const { return next[i]; }
+
+    // Links position i at the head of bucket
+    void link(PointIndex i, size_t bucket);
+
+    // Unlinks position i, which is in bucket
+    void unlink(PointIndex i, size_t bucket);
+
+    // The point linked at position from, in bucket, is now at position to, which is not linked
+    void relabel(PointIndex from, PointIndex to, size_t bucket);
+};
+
+// Buckets of points by coordinate cell. A lookup matches by CoordTraits<Coord>::equal: for
+// double that is the 1e-9 epsilon, so cells are 4e-9 wide and the 3x3 cells around the query
+// are probed; the other types match exactly and probe one cell. The index refers to positions
+// in a span it does not own; the caller keeps them in sync.
+template <typename Coord>
+class PointHash {
+private:
+    BucketChains chains; // a power of two of buckets
+
+    size_t bucketOf(uint64_t cellX, uint64_t cellY) const;
+
+    size_t bucketOf(Coord x, Coord y) const;
+
+    // Rebuilds the buckets for the first count positions of points with room for capacity points
+    void rehash(const BasicPointSpan<Coord>& points, size_t capacity);
+
+public:
+    void clear() { chains.clear(); }
+
+    // Indexes every point of points
+    void assign(const BasicPointSpan<Coord>& points);
+
+    // Indexes the point at position i, which must be points.size - 1
+    void insert(const BasicPointSpan<Coord>& points, PointIndex i);
+
+    // Position of a point equal to (x, y), or points.size if there is none. O(1) expected
+    size_t find(const BasicPointSpan<Coord>& points, Coord x, Coord y) const;
+
+    // Drops position i; its coordinates must still be in points
+    void erase(const BasicPointSpan<Coord>& points, PointIndex i);
+
+    // The point indexed at position from is now at position to, which is not indexed
+    void relabel(const BasicPointSpan<Coord>& points, PointIndex from, PointIndex to);
+};
+
+// Uniform grid over the bounding box the points had when it was built, about two points per
+// cell. Points added outside the box go to the border cells until the next rebuild, which
+// happens when the point count doubles, so queries stay correct and inserts O(1) amortized.
+// Like PointHash, it refers to positions in a span it does not own.
+template <typename Coord>
+class PointGrid {
+private:
+    BucketChains chains; // cell (column, row) is bucket row * columns + column
+    double originX, originY; // lower left corner of the bounding box
+    double columnsPerUnit, rowsPerUnit; // inverse cell sizes, 0 along an empty extent
+    size_t columns, rows;
+
+    size_t columnOf(Coord x) const;
+
+    size_t rowOf(Coord y) const;
+
+    size_t cellOf(Coord x, Coord y) const { return rowOf(y) * columns + columnOf(x); }
+
+    // Fits the grid to the first count positions of points with room for capacity points
+    void rebuild(const BasicPointSpan<Coord>& points, size_t capacity);
+
+public:
+    PointGrid() : originX(0), originY(0), columnsPerUnit(0), rowsPerUnit(0), columns(1), rows(1) {}
+
+    void clear() { chains.clear(); }
+
+    void assign(const BasicPointSpan<Coord>& points);
+
+    // Indexes the point at position i, which must be points.size - 1
+    void insert(const BasicPointSpan<Coord>& points, PointIndex i);
+
+    // Appends to out the positions of the points with minX <= x <= maxX and minY <= y <= maxY.
+    // Visits only the cells the rectangle overlaps
+    void findInRect(const BasicPointSpan<Coord>& points, Coord minX, Coord minY, Coord maxX, Coord maxY,
+                    std::vector<PointIndex>& out) const;
+
+    // Drops position i; its coordinates must still be in points
+    void erase(const BasicPointSpan<Coord>& points, PointIndex i);
+
+    // The point indexed at position from is now at position to, which is not indexed
+    void relabel(const BasicPointSpan<Coord>& points, PointIndex from, PointIndex to);
+};
+
+// A PointStore with a PointHash and a PointGrid kept in sync. Each index is built by its first
+// query and then maintained by push_back and swapRemove, so graphs that are never searched
+// never pay for it.
+//
+// With dedup on, a point equal to a stored one (by CoordTraits<Coord>::equal, through the hash)
+// only bumps the multiplicity of the stored one, so the span, and the hull engines reading it,
+// see each distinct point once. Positions and size() count distinct points, total() all of them.
+template <typename Coord>
+class IndexedPointStore {
+private:
+    BasicPointStore<Coord> store;
+    PointHash<Coord> hash;
+    PointGrid<Coord> grid;
+    bool hashed;
+    bool gridded;
+
+    bool dedup;
+    std::vector<uint32_t> counts; // multiplicity of each position while dedup is on
+    size_t totalPoints;
+
+    // Adds (x, y) as a new distinct point
+    void append(Coord x, Coord y, uint32_t count);
+
+public:
+    typedef Coord value_type;
+
+    IndexedPointStore() : hashed(false), gridded(false), dedup(false), totalPoints(0) {}
+
+    size_t size() const { return store.size(); }
+
+    // Points added and not removed, repeats included
+    size_t total() const { return totalPoints; }
+
+    bool empty() const { return store.empty(); }
+
+    void clear();
+
+    // Room for n points; skipped under dedup, where n says little about the distinct count
+    void reserve(size_t n) {
+        if (!dedup) {
+            store.reserve(n);
+        }
+    }
+
+    // Grows or shrinks to n points; new points are (0, 0). Drops both indexes
+    void resize(size_t n);
+
+    // Replaces the points with the n points of the arrays x and y, collapsed under dedup
+    void assign(const Coord* x, const Coord* y, size_t n);
+
+    // Replaces the points with the writable arrays x and y, kept alive by owner, without a
+    // copy, see BasicPointStore::adopt. Under dedup they are collapsed into a copy instead
+    void adopt(Coord* x, Coord* y, size_t n, std::shared_ptr<void> owner);
+
+    // Turns dedup on or off, collapsing or expanding the points already stored
+    void setDedup(bool enabled);
+
+    bool isDedup() const { return dedup; }
+
+    // Adds (x, y) and returns its position, that of the equal point already stored under dedup
+    size_t push_back(Coord x, Coord y);
+
+    size_t push_back(const Point& p) { return push_back(static_cast<Coord>(p.x), static_cast<Coord>(p.y)); }
+
+    // Copies of point i in the graph, 1 unless dedup merged repeats into it
+    uint32_t multiplicity(size_t i) const { return dedup ? counts[i] : 1; }
+
+    Point at(size_t i) const { return store.at(i); }
+
+    BasicPointSpan<Coord> span() const { return store.span(); }
+
+    // Position of a point equal to (x, y) by CoordTraits<Coord>::equal, or size() if there is none
+    size_t find(Coord x, Coord y);
+
+    // Appends to out the positions of the points inside the rectangle, bounds included
+    void findInRect(Coord minX, Coord minY, Coord maxX, Coord maxY, std::vector<PointIndex>& out);
+
+    // Removes point i and all its copies by moving the last point into its place. O(1)
+    void swapRemove(size_t i);
+
+    // Removes one copy of point i, and the point itself with its last copy. O(1)
+    void removeCopy(size_t i);
+};
+
+#endif //POINTHASH_HPP
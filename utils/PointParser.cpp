@@ -0,0 +1,254 @@
+#include "PointParser.hpp"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+    bool fastDecimal = true;
+
+    bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    const char* skipBlanks(const char* p, const char* end) {
+        while (p != end && isBlank(*p)) {
+            ++p;
+        }
+        return p;
+    }
+
+    const uint64_t INTEGER_POWERS_OF_TEN[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+    // Number of ASCII digits chunk starts with, its first byte being the lowest. A byte is a
+    // digit when its high nibble is 3 both as is and after adding 6; a carry out of a byte only
+    // reaches the bytes after it, so the count is exact
+    unsigned leadingDigits(uint64_t chunk) {
+        uint64_t nibbles = (chunk & 0xF0F0F0F0F0F0F0F0ull) |
+                           (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4);
+        uint64_t nonDigits = nibbles ^ 0x3333333333333333ull;
+        return nonDigits == 0 ? 8 : static_cast<unsigned>(__builtin_ctzll(nonDigits)) / 8;
+    }
+
+    // Value of the eight ASCII digits of chunk, first digit in the lowest byte: pairs, then
+    // quads, then all eight, with three multiplications
+    uint32_t eightDigits(uint64_t chunk) {
+        chunk -= 0x3030303030303030ull;
+        chunk = chunk * 10 + (chunk >> 8);
+        chunk = (((chunk & 0x000000FF000000FFull) * 0x000F424000000064ull) +
+                 (((chunk >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;
+        return static_cast<uint32_t>(chunk);
+    }
+
+    // Appends the digits at p to value and counts them in digits, up to eight per step while
+    // the buffer has eight more bytes: the digits are moved to the end of the word and the
+    // bytes before them filled with '0'. Digits past the 19th no longer fit and are only counted
+    const char* readDigits(const char* p, const char* end, uint64_t& value, int& digits) {
+        while (end - p >= 8 && digits <= 11) {
+            uint64_t chunk;
+            std::memcpy(&chunk, p, sizeof chunk);
+            unsigned length = leadingDigits(chunk);
+            if (length == 0) {
+                return p;
+            }
+            if (length < 8) {
+                chunk = (chunk << (8 * (8 - length))) | (0x3030303030303030ull >> (8 * length));
+            }
+            value = value * INTEGER_POWERS_OF_TEN[length] + eightDigits(chunk);
+            digits += static_cast<int>(length);
+            p += length;
+            if (length < 8) {
+                return p;
+            }
+        }
+        while (p != end && static_cast<unsigned char>(*p - '0') <= 9) {
+            if (digits < 19) {
+                value = value * 10 + static_cast<unsigned>(*p - '0');
+            }
+            digits++;
+            ++p;
+        }
+        return p;
+    }
+
+    const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    // [-]digits[.digits] with a mantissa below 2^53 and at most 22 decimals: the mantissa and
+    // the power of ten are both exact doubles, so their one correctly rounded quotient is the
+    // value from_chars would give. Returns false, leaving out alone, for anything else
+    bool parsePlainDecimal(const char* p, const char* end, double& out, const char*& next) {
+        bool negative = p != end && *p == '-';
+        if (negative) {
+            ++p;
+        }
+        uint64_t mantissa = 0;
+        int digits = 0;
+        p = readDigits(p, end, mantissa, digits);
+        int decimals = 0;
+        if (p != end && *p == '.') {
+            const char* first = ++p;
+            p = readDigits(p, end, mantissa, digits);
+            decimals = static_cast<int>(p - first);
+        }
+        if (digits == 0 || digits > 19 || mantissa >= (static_cast<uint64_t>(1) << 53) || decimals > 22 ||
+            (p != end && (*p == 'e' || *p == 'E'))) {
+            return false;
+        }
+        double value = static_cast<double>(mantissa) / POWERS_OF_TEN[decimals];
+        out = negative ? -value : value;
+        next = p;
+        return true;
+    }
+
+    ParseStatus statusOf(std::errc ec) {
+        if (ec == std::errc::result_out_of_range) {
+            return ParseStatus::OutOfRange;
+        }
+        return ec == std::errc() ? ParseStatus::Ok : ParseStatus::BadNumber;
+    }
+}
+
+const char* parseStatusMessage(ParseStatus status) {
+    switch (status) {
+        case ParseStatus::Ok:
+            return "ok";
+        case ParseStatus::Empty:
+            return "empty point";
+        case ParseStatus::MissingComma:
+            return "missing comma";
+        case ParseStatus::BadNumber:
+            return "not a number";
+        case ParseStatus::OutOfRange:
+            return "coordinate out of range";
+        case ParseStatus::TrailingText:
+        default:
+            return "unexpected text after a coordinate";
+    }
+}
+
+void setFastDecimalParsing(bool enabled) {
+    fastDecimal = enabled;
+}
+
+bool fastDecimalParsing() {
+    return fastDecimal;
+}
+
+template <typename Coord>
+ParseStatus parseCoordinate(std::string_view& text, Coord& out) {
+    const char* end = text.data() + text.size();
+    const char* p = skipBlanks(text.data(), end);
+    if (p == end) {
+        return ParseStatus::Empty;
+    }
+    // strtod took a leading '+', from_chars does not
+    if (*p == '+' && end - p > 1 && p[1] != '-') {
+        ++p;
+    }
+    const char* next = p;
+    ParseStatus status;
+    if constexpr (std::is_integral<Coord>::value) {
+        long long value = 0;
+        std::from_chars_result parsed = std::from_chars(p, end, value);
+        next = parsed.ptr;
+        status = statusOf(parsed.ec);
+        if (status == ParseStatus::Ok && (value < -CoordTraits<Coord>::limit || value > CoordTraits<Coord>::limit)) {
+            status = ParseStatus::OutOfRange;
+        }
+        if (status == ParseStatus::Ok) {
+            out = static_cast<Coord>(value);
+        }
+    } else {
+        bool parsedFast = false;
+        if constexpr (std::is_same<Coord, double>::value) {
+            parsedFast = fastDecimal && parsePlainDecimal(p, end, out, next);
+        }
+        if (parsedFast) {
+            status = ParseStatus::Ok;
+        } else {
+            std::from_chars_result parsed = std::from_chars(p, end, out);
+            next = parsed.ptr;
+            status = statusOf(parsed.ec);
+        }
+    }
+    text = std::string_view(next, static_cast<size_t>(end - next));
+    return status;
+}
+
+template <typename Coord>
+ParseStatus parsePointText(std::string_view text, Coord& x, Coord& y) {
+    Coord parsedX, parsedY;
+    ParseStatus status = parseCoordinate(text, parsedX);
+    if (status != ParseStatus::Ok) {
+        return status;
+    }
+    const char* end = text.data() + text.size();
+    const char* p = skipBlanks(text.data(), end);
+    if (p == end || *p != ',') {
+        return p == end ? ParseStatus::MissingComma : ParseStatus::TrailingText;
+    }
+    text = std::string_view(p + 1, static_cast<size_t>(end - p - 1));
+    status = parseCoordinate(text, parsedY);
+    if (status != ParseStatus::Ok) {
+        return status == ParseStatus::Empty ? ParseStatus::BadNumber : status;
+    }
+    if (skipBlanks(text.data(), end) != end) {
+        return ParseStatus::TrailingText;
+    }
+    x = parsedX;
+    y = parsedY;
+    return ParseStatus::Ok;
+}
+
+template <typename Coord>
+ParseStatus parseCoordinateList(std::string_view text, Coord* out, size_t count) {
+    for (size_t k = 0; k < count; ++k) {
+        ParseStatus status = parseCoordinate(text, out[k]);
+        if (status != ParseStatus::Ok) {
+            return status;
+        }
+        const char* end = text.data() + text.size();
+        const char* p = skipBlanks(text.data(), end);
+        if (k + 1 == count) {
+            return p == end ? ParseStatus::Ok : ParseStatus::TrailingText;
+        }
+        if (p == end || *p != ',') {
+            return p == end ? ParseStatus::MissingComma : ParseStatus::TrailingText;
+        }
+        text = std::string_view(p + 1, static_cast<size_t>(end - p - 1));
+    }
+    return ParseStatus::Ok;
+}
+
+#define POINT_PARSER_INSTANTIATE(Coord) \
+    template ParseStatus parseCoordinate<Coord>(std::string_view&, Coord&); \
+    template ParseStatus parsePointText<Coord>(std::string_view, Coord&, Coord&); \
+    template ParseStatus parseCoordinateList<Coord>(std::string_view, Coord*, size_t);
+
+POINT_PARSER_INSTANTIATE(double)
+POINT_PARSER_INSTANTIATE(float)
+POINT_PARSER_INSTANTIATE(int32_t)
+POINT_PARSER_INSTANTIATE(int64_t)
+
+std::string readAll(FILE* file) {
+    std::string input;
+    char chunk[1 << 16];
+    size_t bytes;
+    while ((bytes = fread(chunk, 1, sizeof chunk, file)) > 0) {
+        input.append(chunk, bytes);
+    }
+    return input;
+}
+
+size_t takePointCount(std::string_view& text) {
+    size_t firstLine = text.find('\n');
+    std::string_view header = text.substr(0, firstLine);
+    size_t digits = header.find_first_not_of(" \t");
+    int n = 0;
+    if (digits != std::string_view::npos) {
+        std::from_chars(header.data() + digits, header.data() + header.size(), n);
+    }
+    text.remove_prefix(firstLine == std::string_view::npos ? text.size() : firstLine + 1);
+    return n < 0 ? 0 : static_cast<size_t>(n);
+}
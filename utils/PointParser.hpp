@@ -0,0 +1,106 @@
+//
+// Allocation-free parsing of "x,y" points, one at a time or a whole buffer of lines in one pass.
+//
+
+#ifndef POINTPARSER_HPP
+#define POINTPARSER_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include "Coordinate.hpp"
+
+// Outcome of parsing a coordinate or a point
+enum class ParseStatus {
+    Ok,
+    Empty,        // nothing but blanks
+    MissingComma, // no ',' after the x coordinate
+    BadNumber,    // a coordinate is not a number of the coordinate type
+    OutOfRange,   // a coordinate overflows the type or is beyond CoordTraits<Coord>::limit
+    TrailingText  // something other than blanks after a coordinate
+};
+
+// Short description of status, for error replies
+const char* parseStatusMessage(ParseStatus status);
+
+// Parses the coordinate at the start of text, after blanks and an optional '+', and advances
+// text past it. Numbers are read with std::from_chars, so nothing is copied, allocated or thrown
+template <typename Coord>
+ParseStatus parseCoordinate(std::string_view& text, Coord& out);
+
+// Parses "x,y" with optional blanks around both coordinates. x and y are only written on Ok
+template <typename Coord>
+ParseStatus parsePointText(std::string_view text, Coord& x, Coord& y);
+
+// Parses "x1,y1,x2,..." into the count coordinates of out, with nothing after the last
+template <typename Coord>
+ParseStatus parseCoordinateList(std::string_view text, Coord* out, size_t count);
+
+// Takes plain decimals ([-]digits[.digits] with a mantissa below 2^53 and at most 22 decimals)
+// for double coordinates without std::from_chars, up to eight digits per step in one 64-bit word.
+// The result is the same correctly rounded double; on by default, turned off to compare the two
+void setFastDecimalParsing(bool enabled);
+
+bool fastDecimalParsing();
+
+// What parsePointLines did with a buffer
+struct LineParseResult {
+    size_t points = 0;                     // points handed to add
+    size_t errors = 0;                     // malformed lines, skipped
+    size_t firstErrorLine = 0;             // line of the first malformed one, from 1, 0 if none
+    ParseStatus firstError = ParseStatus::Ok;
+    size_t consumed = 0;                   // bytes of the buffer read, whole lines only
+};
+
+// Parses the "x,y" lines of buffer in one pass, calling add(x, y) for every well-formed one
+// until maxPoints points were added. Blank lines are skipped; malformed ones are counted and
+// skipped. Lines end in '\n', a '\r' before it is a blank
+template <typename Coord, typename Add>
+LineParseResult parsePointLines(std::string_view buffer, size_t maxPoints, Add add) {
+    LineParseResult result;
+    size_t line = 0;
+    while (result.consumed < buffer.size() && result.points < maxPoints) {
+        size_t newline = buffer.find('\n', result.consumed);
+        size_t lineEnd = newline == std::string_view::npos ? buffer.size() : newline;
+        std::string_view text = buffer.substr(result.consumed, lineEnd - result.consumed);
+        result.consumed = newline == std::string_view::npos ? buffer.size() : newline + 1;
+        line++;
+        Coord x, y;
+        ParseStatus status = parsePointText(text, x, y);
+        if (status == ParseStatus::Ok) {
+            add(x, y);
+            result.points++;
+        } else if (status != ParseStatus::Empty) {
+            if (result.errors++ == 0) {
+                result.firstErrorLine = line;
+                result.firstError = status;
+            }
+        }
+    }
+    return result;
+}
+
+// All the bytes left in file, read in large chunks
+std::string readAll(FILE* file);
+
+// Takes the first line of text, a point count, and returns it; 0 if it is missing or negative
+size_t takePointCount(std::string_view& text);
+
+// Reads the point input of the command line programs from file, a point count on the first line
+// and then one "x,y" point per line, and parses it in place with parsePointLines. Malformed
+// lines are reported on stderr, numbered from the top of the input
+template <typename Coord, typename Add>
+LineParseResult readPointInput(FILE* file, Add add) {
+    std::string input = readAll(file);
+    std::string_view text(input);
+    size_t count = takePointCount(text);
+    LineParseResult parsed = parsePointLines<Coord>(text, count, add);
+    if (parsed.errors > 0) {
+        fprintf(stderr, "%zu malformed points skipped, the first on line %zu: %s\n", parsed.errors,
+                parsed.firstErrorLine + 1, parseStatusMessage(parsed.firstError));
+    }
+    return parsed;
+}
+
+#endif //POINTPARSER_HPP
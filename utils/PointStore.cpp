@@ -0,0 +1,158 @@
+#include "PointStore.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+    const size_t ALIGNMENT = 64;
+
+    template <typename Coord>
+    Coord* allocateCoordinates(size_t n) {
+        // aligned_alloc wants a size that is a multiple of the alignment
+        size_t bytes = (n * sizeof(Coord) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        void* memory = aligned_alloc(ALIGNMENT, bytes);
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<Coord*>(memory);
+    }
+}
+
+template <typename Coord>
+BasicPointStore<Coord>::BasicPointStore(const std::vector<Point>& points) : xs(nullptr), ys(nullptr), count(0), capacity(0) {
+    reserve(points.size());
+    for (const Point& p: points) {
+        xs[count] = static_cast<Coord>(p.x);
+        ys[count] = static_cast<Coord>(p.y);
+        count++;
+    }
+}
+
+template <typename Coord>
+BasicPointStore<Coord>::BasicPointStore(const BasicPointStore& other) : xs(nullptr), ys(nullptr), count(0), capacity(0) {
+    *this = other;
+}
+
+template <typename Coord>
+BasicPointStore<Coord>& BasicPointStore<Coord>::operator=(const BasicPointStore& other) {
+    if (this != &other) {
+        count = 0;
+        reserve(other.count);
+        if (other.count > 0) {
+            std::memcpy(xs, other.xs, other.count * sizeof(Coord));
+            std::memcpy(ys, other.ys, other.count * sizeof(Coord));
+        }
+        count = other.count;
+    }
+    return *this;
+}
+
+template <typename Coord>
+BasicPointStore<Coord>::~BasicPointStore() {
+    release();
+}
+
+template <typename Coord>
+void BasicPointStore<Coord>::release() {
+    if (backing) {
+        backing.reset();
+    } else {
+        free(xs);
+        free(ys);
+    }
+    xs = ys = nullptr;
+}
+
+template <typename Coord>
+void BasicPointStore<Coord>::grow(size_t minCapacity) {
+    size_t newCapacity = capacity ? capacity : 16;
+    while (newCapacity < minCapacity) {
+        newCapacity *= 2;
+    }
+    Coord* newXs = allocateCoordinates<Coord>(newCapacity);
+    Coord* newYs = allocateCoordinates<Coord>(newCapacity);
+    if (count > 0) {
+        std::memcpy(newXs, xs, count * sizeof(Coord));
+        std::memcpy(newYs, ys, count * sizeof(Coord));
+    }
+    release();
+    xs = newXs;
+    ys = newYs;
+    capacity = newCapacity;
+}
+
+template <typename Coord>
+void BasicPointStore<Coord>::reserve(size_t n) {
+    if (n > capacity) {
+        grow(n);
+    }
+}
+
+template <typename Coord>
+void BasicPointStore<Coord>::resize(size_t n) {
+    reserve(n);
+    for (size_t i = count; i < n; ++i) {
+        xs[i] = 0;
+        ys[i] = 0;
+    }
+    count = n;
+}
+
+template <typename Coord>
+void BasicPointStore<Coord>::assign(const Coord* x, const Coord* y, size_t n) {
+    count = 0;
+    reserve(n);
+    if (n > 0) {
+        std::memcpy(xs, x, n * sizeof(Coord));
+        std::memcpy(ys, y, n * sizeof(Coord));
+    }
+    count = n;
+}
+
+template <typename Coord>
+void BasicPointStore<Coord>::adopt(Coord* x, Coord* y, size_t n, std::shared_ptr<void> owner) {
+    release();
+    xs = x;
+    ys = y;
+    count = capacity = n;
+    backing = std::move(owner);
+}
+
+template <typename Coord>
+void BasicPointStore<Coord>::push_back(Coord x, Coord y) {
+    if (count == capacity) {
+        grow(count + 1);
+    }
+    xs[count] = x;
+    ys[count] = y;
+    count++;
+}
+
+template <typename Coord>
+void BasicPointStore<Coord>::erase(size_t i) {
+    std::memmove(xs + i, xs + i + 1, (count - i - 1) * sizeof(Coord));
+    std::memmove(ys + i, ys + i + 1, (count - i - 1) * sizeof(Coord));
+    count--;
+}
+
+template <typename Coord>
+void BasicPointStore<Coord>::swapRemove(size_t i) {
+    count--;
+    xs[i] = xs[count];
+    ys[i] = ys[count];
+}
+
+template <typename Coord>
+size_t BasicPointStore<Coord>::find(Coord x, Coord y) const {
+    for (size_t i = 0; i < count; ++i) {
+        if (CoordTraits<Coord>::equal(xs[i], x) && CoordTraits<Coord>::equal(ys[i], y)) {
+            return i;
+        }
+    }
+    return count;
+}
+
+template class BasicPointStore<double>;
+template class BasicPointStore<float>;
+template class BasicPointStore<int32_t>;
+template class BasicPointStore<int64_t>;
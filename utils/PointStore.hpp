@@ -0,0 +1,109 @@
+//
+// Structure-of-arrays point storage: x and y coordinates in separate aligned arrays.
+//
+
+#ifndef POINTSTORE_HPP
+#define POINTSTORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Coordinate.hpp"
+#include "Point.hpp"
+
+// Position of a point in a PointStore or PointSpan. Graphs are capped at INT32_MAX points
+typedef uint32_t PointIndex;
+
+// Read-only view of n points stored as separate x and y arrays
+template <typename Coord>
+struct BasicPointSpan {
+    const Coord* x;
+    const Coord* y;
+    size_t size;
+
+    // Point i converted to double coordinates
+    Point at(size_t i) const { return Point(x[i], y[i]); }
+
+    // Points [first, last) of this span
+    BasicPointSpan sub(size_t first, size_t last) const { return {x + first, y + first, last - first}; }
+};
+
+// Owns points as two 64-byte aligned arrays, so one-coordinate passes read only that coordinate
+// and SIMD loads never split a cache line. Grows by doubling like std::vector. Instantiated for
+// the coordinate types of CoordType in PointStore.cpp.
+template <typename Coord>
+class BasicPointStore {
+private:
+    Coord* xs;
+    Coord* ys;
+    size_t count;
+    size_t capacity;
+    std::shared_ptr<void> backing; // owner of adopted arrays, null while xs and ys are ours
+
+    // Reallocates both arrays to hold at least minCapacity points
+    void grow(size_t minCapacity);
+
+    // Frees or lets go of the arrays
+    void release();
+
+public:
+    typedef Coord value_type;
+
+    BasicPointStore() : xs(nullptr), ys(nullptr), count(0), capacity(0) {}
+
+    explicit BasicPointStore(const std::vector<Point>& points);
+
+    BasicPointStore(const BasicPointStore& other);
+
+    BasicPointStore& operator=(const BasicPointStore& other);
+
+    ~BasicPointStore();
+
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    void clear() { count = 0; }
+
+    void reserve(size_t n);
+
+    // Grows or shrinks to n points; new points are (0, 0)
+    void resize(size_t n);
+
+    // Replaces the points with the n points of the arrays x and y
+    void assign(const Coord* x, const Coord* y, size_t n);
+
+    // Uses the writable arrays x and y, kept alive by owner, as the points instead of copying
+    // them. They are edited in place; the first growth copies them into arrays of the store
+    void adopt(Coord* x, Coord* y, size_t n, std::shared_ptr<void> owner);
+
+    void push_back(Coord x, Coord y);
+
+    // Adds p converted to Coord
+    void push_back(const Point& p) { push_back(static_cast<Coord>(p.x), static_cast<Coord>(p.y)); }
+
+    // Removes point i, keeping the order of the rest. O(n)
+    void erase(size_t i);
+
+    // Removes point i by moving the last point into its place. O(1)
+    void swapRemove(size_t i);
+
+    Point at(size_t i) const { return Point(xs[i], ys[i]); }
+
+    const Coord* x() const { return xs; }
+
+    const Coord* y() const { return ys; }
+
+    BasicPointSpan<Coord> span() const { return {xs, ys, count}; }
+
+    // Index of the first point equal to (x, y) by CoordTraits<Coord>::equal, or size() if there is none
+    size_t find(Coord x, Coord y) const;
+
+    size_t find(const Point& p) const { return find(static_cast<Coord>(p.x), static_cast<Coord>(p.y)); }
+};
+
+typedef BasicPointSpan<double> PointSpan;
+typedef BasicPointStore<double> PointStore;
+
+#endif //POINTSTORE_HPP
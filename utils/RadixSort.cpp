@@ -0,0 +1,78 @@
+#include "RadixSort.hpp"
+#include <algorithm>
+
+namespace {
+    const int DIGIT_BITS = 11;
+    const int DIGIT_COUNT = (64 + DIGIT_BITS - 1) / DIGIT_BITS;
+    const uint32_t BUCKETS = 1u << DIGIT_BITS;
+    const uint64_t DIGIT_MASK = BUCKETS - 1;
+
+    struct KeyedIndex {
+        uint64_t key;
+        PointIndex index;
+    };
+}
+
+template <typename Coord>
+void radixSortIndicesByXY(const BasicPointSpan<Coord>& points, PointIndex* idx, size_t n) {
+    auto lessXY = [&points](PointIndex a, PointIndex b) {
+        return points.x[a] < points.x[b] || (points.x[a] == points.x[b] && points.y[a] < points.y[b]);
+    };
+    if (n < 1024) {
+        // histograms cost more than they save on small inputs
+        std::sort(idx, idx + n, lessXY);
+        return;
+    }
+
+    // one pass to build the keys and the histograms of every digit of the x key
+    std::vector<KeyedIndex> keyed(n);
+    std::vector<uint32_t> counts(DIGIT_COUNT * BUCKETS, 0);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t key = orderedKey(points.x[idx[i]]);
+        keyed[i].key = key;
+        keyed[i].index = idx[i];
+        for (int d = 0; d < DIGIT_COUNT; ++d) {
+            counts[d * BUCKETS + ((key >> (d * DIGIT_BITS)) & DIGIT_MASK)]++;
+        }
+    }
+
+    std::vector<KeyedIndex> buffer(n);
+    KeyedIndex* src = keyed.data();
+    KeyedIndex* dst = buffer.data();
+    for (int d = 0; d < DIGIT_COUNT; ++d) {
+        uint32_t* count = &counts[d * BUCKETS];
+        int shift = d * DIGIT_BITS;
+        if (count[(src[0].key >> shift) & DIGIT_MASK] == n) {
+            continue; // every key has the same digit here
+        }
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < BUCKETS; ++i) {
+            uint32_t c = count[i];
+            count[i] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            dst[count[(src[i].key >> shift) & DIGIT_MASK]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    // write back, ordering runs of equal x by y; such runs are rare for real coordinates and
+    // short on grids
+    for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && src[j].key == src[i].key) ++j;
+        for (size_t k = i; k < j; ++k) {
+            idx[k] = src[k].index;
+        }
+        if (j - i > 1) {
+            std::sort(idx + i, idx + j, lessXY);
+        }
+        i = j;
+    }
+}
+
+template void radixSortIndicesByXY(const BasicPointSpan<double>&, PointIndex*, size_t);
+template void radixSortIndicesByXY(const BasicPointSpan<float>&, PointIndex*, size_t);
+template void radixSortIndicesByXY(const BasicPointSpan<int32_t>&, PointIndex*, size_t);
+template void radixSortIndicesByXY(const BasicPointSpan<int64_t>&, PointIndex*, size_t);
@@ -0,0 +1,46 @@
+//
+// LSD radix sort of point indices on order-preserving integer keys of the coordinates.
+//
+
+#ifndef RADIXSORT_HPP
+#define RADIXSORT_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "PointStore.hpp"
+
+// Maps a double to an unsigned key with the same order: flips all bits of negatives
+// and only the sign bit of non-negatives. -0.0 maps to the key of 0.0 as they compare equal
+inline uint64_t orderedKey(double d) {
+    if (d == 0.0) {
+        d = 0.0;
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof bits);
+    return (bits & 0x8000000000000000ull) ? ~bits : (bits | 0x8000000000000000ull);
+}
+
+// Every float is exactly a double
+inline uint64_t orderedKey(float f) {
+    return orderedKey(static_cast<double>(f));
+}
+
+// Flipping the sign bit orders two's complement integers as unsigned
+inline uint64_t orderedKey(int64_t i) {
+    return static_cast<uint64_t>(i) ^ 0x8000000000000000ull;
+}
+
+// Same within 32 bits, so the upper digits of every key are zero and their passes are skipped
+inline uint64_t orderedKey(int32_t i) {
+    return static_cast<uint32_t>(i) ^ 0x80000000u;
+}
+
+// Sorts idx[0..n) by the (x, y) of the points they refer to: 11-bit LSD passes over (x key, index)
+// pairs, skipping a pass when every key shares that digit (most of them on integer grids), then a
+// comparison sort of each equal-x run. Only the x array is read until the runs are fixed up.
+// int32 keys fit in 3 digits, so int32 graphs sort in at most 3 passes.
+template <typename Coord>
+void radixSortIndicesByXY(const BasicPointSpan<Coord>& points, PointIndex* idx, size_t n);
+
+#endif //RADIXSORT_HPP
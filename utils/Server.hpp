@@ -13,6 +13,7 @@
 #include <netdb.h>
 #include <algorithm>
 #include <cmath>
+#include <cerrno>
 #include <string>
 #include <sstream>
 #include <csignal>
@@ -28,7 +29,8 @@ void *get_in_addr(struct sockaddr *sa);
 
 void handleRequest(int clientfd);
 
-void handleCommand(int clientfd, const std::string &input_command);
+// Sends all length bytes of data, retrying short sends. Returns false if the connection failed
+bool sendAll(int fd, const char *data, size_t length);
 
 void handleAcceptClient(int fd_listener);
 
@@ -47,6 +49,21 @@ void *get_in_addr(struct sockaddr *sa) {
     return &(((struct sockaddr_in6 *) sa)->sin6_addr);
 }
 
+bool sendAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
 // Signal handler for graceful shutdown
 void signalHandler(int signum) {
     std::cout << "\nInterrupt signal (" << signum << ") received.\n";
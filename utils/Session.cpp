@@ -0,0 +1,309 @@
+#include "Session.hpp"
+#include "GraphRegistry.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+Session::Session(SharedGraph *home, GraphRegistry *registry)
+    : home(home), shared(home), registry(registry), isPrivate(false), isWaitingForPoints(0), expectedPoints(0),
+      expectedType(CoordType::Double), binary(false), skipping(0) {
+}
+
+bool Session::useNamedGraph(std::string_view name) {
+    if (registry == nullptr) {
+        return false;
+    }
+    shared = registry->getOrCreate(std::string(name));
+    isPrivate = false;
+    return true;
+}
+
+const char *Session::startNewGraph(int n, CoordType type) {
+    expectedPoints = n;
+    expectedType = type;
+    isWaitingForPoints = n;
+    pendingLines.clear();
+    if (n == 0) {
+        commitNewGraph();
+    }
+    return "Insert points as x, y. line by line.";
+}
+
+LineParseResult Session::commitNewGraph() {
+    LineParseResult result;
+    if (isPrivate) {
+        result = privateGraph->commandNewGraph(expectedPoints, pendingLines, expectedType);
+    } else {
+        std::lock_guard<std::mutex> lock(shared->mtx);
+        result = shared->calculator.commandNewGraph(expectedPoints, pendingLines, expectedType);
+    }
+    pendingLines.clear();
+    return result;
+}
+
+void Session::runOnGraph(Command command, std::string_view args) {
+    withGraph([&](ConvexHullCalculator &calculator) { calculator.dispatch(command, args, output); });
+}
+
+void Session::handleLine(std::string_view line) {
+    line = trimBlanks(line);
+    if (isWaitingForPoints) {
+        if (line.find(',') != std::string_view::npos) {
+            // the whole line, so "x, y" keeps its y
+            pendingLines += line;
+            pendingLines += '\n';
+            isWaitingForPoints--;
+            std::string_view rest = line;
+            output.append("Point (").append(nextToken(rest)).append(") was added.");
+            if (!isWaitingForPoints) {
+                LineParseResult result = commitNewGraph();
+                if (result.errors > 0) {
+                    output += " ";
+                    appendInteger(output, result.errors);
+                    output += " malformed points were skipped.";
+                }
+            }
+        } else {
+            output += "Error. Insert point as x, y.";
+        }
+        output += "\n";
+        return;
+    }
+    std::string_view args = line;
+    std::string_view name = nextToken(args);
+    // an empty line ends the session like exit
+    Command command = name.empty() ? Command::Exit : lookupCommand(name);
+    if (command == Command::Newgraph) {
+        // "Newgraph n" fills the bound graph, "Newgraph <name> n" binds to a named graph first;
+        // either may end in a coordinate type, double by default
+        std::string_view words[4];
+        size_t count = 0;
+        while (count < 4 && !(words[count] = nextToken(args)).empty()) {
+            count++;
+        }
+        CoordType type = CoordType::Double;
+        if (count > 1 && ConvexHullCalculator::parseCoordType(words[count - 1], type)) {
+            count--;
+        }
+        long n = -1;
+        bool valid = count == 1 || count == 2;
+        if (valid) {
+            std::string_view number = words[count - 1];
+            std::from_chars_result parsed = std::from_chars(number.data(), number.data() + number.size(), n);
+            valid = parsed.ec == std::errc() && parsed.ptr == number.data() + number.size() && n >= 0 &&
+                    n <= INT32_MAX;
+        }
+        if (!valid) {
+            output += "Invalid Newgraph command. Usage: Newgraph [name] n [double|float|int32|int64]";
+        } else if (count == 2 && !useNamedGraph(words[0])) {
+            output += "Named graphs are not available.";
+        } else {
+            output += startNewGraph(static_cast<int>(n), type);
+        }
+    } else if (command == Command::Use) {
+        std::string_view graph = nextToken(args);
+        if (graph.empty()) {
+            output += "Invalid Use command. Usage: Use <name>";
+        } else if (useNamedGraph(graph)) {
+            output.append("Using graph ").append(graph).append(".");
+        } else {
+            output += "Named graphs are not available.";
+        }
+    } else if (command == Command::Private) {
+        if (!privateGraph) {
+            privateGraph.reset(new ConvexHullCalculator());
+        }
+        isPrivate = true;
+        output += "Using a private graph.";
+    } else if (command == Command::Shared) {
+        shared = home;
+        isPrivate = false;
+        output += "Using the shared graph.";
+    } else if (command == Command::Binary) {
+        // this reply is the last line; whatever follows it in input is read as messages
+        binary = true;
+        output += "Binary protocol on.";
+    } else {
+        runOnGraph(command, args);
+    }
+    output += "\n";
+}
+
+size_t Session::beginReply(WireType type) {
+    size_t start = output.size();
+    WireHeader header = {0, static_cast<uint32_t>(type)};
+    output.append(reinterpret_cast<const char *>(&header), sizeof header);
+    return start;
+}
+
+void Session::endReply(size_t start) {
+    uint32_t length = static_cast<uint32_t>(output.size() - start - sizeof(WireHeader));
+    std::memcpy(&output[start], &length, sizeof length);
+}
+
+void Session::appendError(std::string_view message) {
+    size_t start = beginReply(WireType::ErrorReply);
+    output += message;
+    endReply(start);
+}
+
+void Session::handleMessage(WireType type, std::string_view payload) {
+    switch (type) {
+        case WireType::Command: {
+            size_t start = beginReply(WireType::TextReply);
+            handleLine(payload);
+            output.pop_back(); // the newline
+            endReply(start);
+            return;
+        }
+        case WireType::Points: {
+            PointsBlock block;
+            if (payload.size() < sizeof block) {
+                appendError("Points message shorter than its header.");
+                return;
+            }
+            std::memcpy(&block, payload.data(), sizeof block);
+            payload.remove_prefix(sizeof block);
+            if (block.coordType > static_cast<uint32_t>(CoordType::Int64)) {
+                appendError("Unknown coordinate type.");
+                return;
+            }
+            CoordType type = static_cast<CoordType>(block.coordType);
+            size_t bytes = coordinateSize(type);
+            // count is bounded by the payload, so the product cannot overflow
+            if (block.count > payload.size() || 2 * block.count * bytes != payload.size()) {
+                appendError("Points message size does not match its count.");
+                return;
+            }
+            size_t n = static_cast<size_t>(block.count);
+            const char *x = payload.data();
+            uint64_t total = 0;
+            bool loaded = false;
+            withGraph([&](ConvexHullCalculator &calculator) {
+                loaded = calculator.commandLoadPoints(type, x, x + n * bytes, n);
+                total = calculator.size();
+            });
+            if (!loaded) {
+                appendError("Coordinates out of range.");
+                return;
+            }
+            // a Newgraph waiting for its point lines is superseded
+            isWaitingForPoints = 0;
+            pendingLines.clear();
+            size_t start = beginReply(WireType::CountReply);
+            output.append(reinterpret_cast<const char *>(&total), sizeof total);
+            endReply(start);
+            return;
+        }
+        case WireType::Area: {
+            double area = 0;
+            withGraph([&area](ConvexHullCalculator &calculator) { area = calculator.commandCalculateHull(); });
+            size_t start = beginReply(WireType::AreaReply);
+            output.append(reinterpret_cast<const char *>(&area), sizeof area);
+            endReply(start);
+            return;
+        }
+        case WireType::Hull: {
+            size_t start = beginReply(WireType::HullReply);
+            withGraph([this](ConvexHullCalculator &calculator) {
+                const std::vector<Point> &hull = calculator.getHull();
+                uint64_t count = hull.size();
+                output.append(reinterpret_cast<const char *>(&count), sizeof count);
+                for (const Point &vertex: hull) {
+                    output.append(reinterpret_cast<const char *>(&vertex.x), sizeof vertex.x);
+                    output.append(reinterpret_cast<const char *>(&vertex.y), sizeof vertex.y);
+                }
+            });
+            endReply(start);
+            return;
+        }
+        case WireType::Text: {
+            binary = false;
+            size_t start = beginReply(WireType::TextReply);
+            output += "Text protocol on.";
+            endReply(start);
+            return;
+        }
+        default:
+            appendError("Unknown message type.");
+            return;
+    }
+}
+
+bool Session::nextMessage() {
+    if (skipping > 0) {
+        size_t dropped = std::min(skipping, input.size());
+        input.consume(dropped);
+        skipping -= dropped;
+        if (skipping > 0) {
+            return false;
+        }
+    }
+    std::string_view unread = input.unread();
+    WireHeader header;
+    if (unread.size() < sizeof header) {
+        return false;
+    }
+    std::memcpy(&header, unread.data(), sizeof header);
+    if (header.length > MAX_WIRE_PAYLOAD) {
+        // skipped rather than buffered, so the next message is still found
+        appendError("Message too long.");
+        input.consume(sizeof header);
+        skipping = header.length;
+        return true;
+    }
+    size_t length = sizeof header + header.length;
+    bool points = static_cast<WireType>(header.type) == WireType::Points;
+    if (unread.size() < length) {
+        // a points block is read into one buffer from its start, so its coordinates end up
+        // aligned like the buffer. The room grows with what has arrived, never by more than
+        // was received so far, so a header alone cannot make the buffer take its full length
+        if (points) {
+            input.compact();
+        }
+        input.prepare(std::min(length - input.size(), input.size()));
+        return false;
+    }
+    if (points && reinterpret_cast<uintptr_t>(unread.data()) % alignof(uint64_t) != 0) {
+        // the coordinates are read in place, which needs them aligned
+        input.compact();
+        unread = input.unread();
+    }
+    input.consume(length);
+    handleMessage(static_cast<WireType>(header.type), unread.substr(sizeof header, header.length));
+    return true;
+}
+
+bool Session::handleInput(size_t maxOutput) {
+    // a command may switch the protocol, so it is checked again before each line or message
+    bool caughtUp = true;
+    for (;;) {
+        if (output.size() >= maxOutput) {
+            caughtUp = false;
+            break;
+        }
+        if (binary) {
+            if (!nextMessage()) {
+                break;
+            }
+            continue;
+        }
+        std::string_view line;
+        if (!input.nextLine(line)) {
+            break;
+        }
+        handleLine(line);
+    }
+    for (size_t dropped = input.takeOverflows(); dropped > 0; dropped--) {
+        output += "Error. Line too long.\n";
+    }
+    return caughtUp;
+}
+
+std::string Session::handleCommand(const std::string &input_command) {
+    handleLine(input_command);
+    std::string response;
+    response.swap(output);
+    return response;
+}
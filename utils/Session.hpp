@@ -0,0 +1,121 @@
+//
+// Per-connection session: owns the Newgraph ingest state of one client and the
+// graph binding it works on.
+//
+
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "ConvexHullCalculator.hpp"
+#include "LineBuffer.hpp"
+#include "WireProtocol.hpp"
+
+class GraphRegistry;
+
+// A graph several sessions may bind to. Every command on it takes its own lock,
+// so sessions on different graphs never contend.
+struct SharedGraph {
+    std::mutex mtx;
+    ConvexHullCalculator calculator;
+};
+
+class Session {
+private:
+    SharedGraph *home; // graph the session starts on and returns to with "Shared", not owned
+    SharedGraph *shared; // graph used while not private: home or a named graph, not owned
+    GraphRegistry *registry; // named graphs for "Use" and "Newgraph <name> n", may be null
+    std::unique_ptr<ConvexHullCalculator> privateGraph; // created on the first "Private"
+    bool isPrivate;
+
+    // Newgraph ingest: the point lines are collected here, one per line, and parsed into the
+    // graph in one pass when the last arrives
+    int isWaitingForPoints;
+    int expectedPoints;
+    CoordType expectedType;
+    std::string pendingLines;
+
+    // Replaces the bound graph with the collected points
+    LineParseResult commitNewGraph();
+
+    // Bytes received and not handled yet: complete lines are handled as soon as they arrive
+    LineBuffer input;
+
+    // Replies not sent yet, newlines included
+    std::string output;
+
+    // Input and replies are WireProtocol messages rather than lines, after "Binary"
+    bool binary;
+    // Bytes of a message too long to accept still to be dropped
+    size_t skipping;
+
+    // Runs f on the calculator of the bound graph, locking it if it is shared
+    template <typename Function>
+    void withGraph(Function f) {
+        if (isPrivate) {
+            f(*privateGraph);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(shared->mtx);
+        f(shared->calculator);
+    }
+
+    // Runs a calculator command on the bound graph
+    void runOnGraph(Command command, std::string_view args);
+
+    // Handles the next complete message of input. Returns false if none is buffered yet
+    bool nextMessage();
+
+    // Handles one message and appends its reply message to output
+    void handleMessage(WireType type, std::string_view payload);
+
+    // Starts a reply message of the given type in output and returns where; endReply fills in
+    // its length once the payload is appended
+    size_t beginReply(WireType type);
+    void endReply(size_t start);
+
+    void appendError(std::string_view message);
+
+    // Binds the session to the named graph. Returns false if there is no registry
+    bool useNamedGraph(std::string_view name);
+
+    // Starts collecting n points of the given coordinate type for the bound graph
+    const char *startNewGraph(int n, CoordType type);
+
+public:
+    Session(SharedGraph *home, GraphRegistry *registry = nullptr);
+
+    // Handles one line from the client and appends the reply, newline included, to
+    // pendingOutput(). Commands are looked up once and replies formatted in place, so in steady
+    // state a command allocates nothing
+    void handleLine(std::string_view line);
+
+    // Buffer the server receives the client's bytes into, see LineBuffer
+    LineBuffer &pendingInput() { return input; }
+
+    // Handles every complete line of pendingInput() in order, so a client may pipeline any number
+    // of commands in one write; a line split across reads waits for its end. The replies are
+    // appended to pendingOutput() for the server to send in one go. After "Binary" the same
+    // holds for messages, see WireProtocol.hpp.
+    // Stops early once pendingOutput() holds maxOutput bytes, leaving the rest of the input for
+    // a later call, so a server can bound the replies queued for a client that does not read
+    // them. Returns false if it stopped early
+    bool handleInput(size_t maxOutput = SIZE_MAX);
+
+    // Replies of handleLine for the server to send. Clearing it keeps its capacity, so the
+    // connection reuses one buffer for all its replies
+    std::string &pendingOutput() { return output; }
+
+    // Handles one line from the client and returns the reply, newline included
+    std::string handleCommand(const std::string &input_command);
+
+    bool isBoundPrivate() const { return isPrivate; }
+
+    bool isBinary() const { return binary; }
+};
+
+#endif //SESSION_HPP
@@ -0,0 +1,56 @@
+//
+// Binary framing a connection may switch to with the text command "Binary": length-prefixed
+// messages, with a bulk points message copied straight into the graph's point store.
+//
+
+#ifndef WIREPROTOCOL_HPP
+#define WIREPROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Every field on the wire is little-endian, which is also the host order the servers are built
+// for, so coordinates go from the socket to the point store without conversion
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the wire format is read in host byte order");
+
+// Starts every message: the length of the payload after this header, then its type
+struct WireHeader {
+    uint32_t length;
+    uint32_t type; // WireType
+};
+
+static_assert(sizeof(WireHeader) == 8, "payloads start 8 bytes into a message");
+
+enum class WireType : uint32_t {
+    // Client to server
+    Command = 1, // a text command line, without its newline; answered by TextReply
+    Points = 2,  // PointsBlock, the x coordinates, then the y coordinates; replaces the graph,
+                 // answered by CountReply
+    Area = 3,    // answered by AreaReply
+    Hull = 4,    // answered by HullReply
+    Text = 5,    // switches the connection back to text lines; answered by TextReply
+
+    // Server to client
+    TextReply = 0x81,  // the text reply of the command, without its newline
+    CountReply = 0x82, // uint64_t points in the graph
+    AreaReply = 0x83,  // double hull area
+    HullReply = 0x84,  // uint64_t vertex count, then the (x, y) doubles of each vertex in
+                       // counter-clockwise order
+    ErrorReply = 0xFF  // what was wrong with the message, as text
+};
+
+// Head of a Points payload. The coordinates follow as two packed arrays of count coordinates of
+// coordType each, like the arrays of a PointStore and of a graph file
+struct PointsBlock {
+    uint32_t coordType; // CoordType
+    uint32_t reserved;  // zero
+    uint64_t count;
+};
+
+static_assert(sizeof(PointsBlock) == 16, "coordinates start 24 bytes into a message");
+
+// Longest payload a server accepts: a points block of 1M double points. Longer messages are
+// skipped unread and answered by ErrorReply
+const uint32_t MAX_WIRE_PAYLOAD = sizeof(PointsBlock) + (1u << 20) * 2 * sizeof(double);
+
+#endif //WIREPROTOCOL_HPP